@@ -0,0 +1,321 @@
+#ifndef ANALYSISCACHE_H
+#define ANALYSISCACHE_H
+
+#include <iostream>
+using namespace std;
+
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Search results kept on disk between runs.
+//
+// The file is a table of buckets of ANALYSIS_BUCKET_SIZE entries behind a small header. It is
+// memory-mapped read-only when the cache is opened, so the search probes it straight from the page
+// cache without reading it in. New results go to an in-memory table of the same shape. A flush
+// merges the current file and the new results into a fresh file and renames it over the old one,
+// so the file is never changed in place: any number of threads and processes can read their
+// mapping while another process flushes. Writers take an exclusive lock on PATH.lock around the
+// merge so none of them loses the others' results. The file never grows past the size it was
+// opened with; when a bucket is full the shallowest result is evicted.
+
+// Only results at least this deep are worth a trip to the cache
+const int ANALYSIS_CACHE_MIN_DEPTH = 5;
+const int ANALYSIS_BUCKET_SIZE = 4;
+// Defaults for the programs that keep a cache
+const size_t ANALYSIS_CACHE_MEGABYTES = 64;
+const int ANALYSIS_FLUSH_SECONDS = 60;
+const char ANALYSIS_CACHE_MAGIC[8] = {'O', 'N', 'I', 'C', 'A', 'C', 'H', '1'};
+
+// A cached result, laid out like a transposition table entry
+struct AnalysisEntry {
+    uint64_t key;
+    int32_t score;
+    int8_t depth;
+    int8_t bound;
+    int8_t x1, y1, x2, y2;
+    int8_t card;
+    int8_t unused;
+};
+
+struct AnalysisCacheHeader {
+    char magic[8];
+    uint64_t buckets;
+};
+
+class AnalysisCache {
+public:
+    AnalysisCache() : mapping(nullptr), mappingBytes(0), mappedEntries(nullptr), mappedBuckets(0),
+                      buckets(0), dirty(false), stopping(false) {}
+
+    ~AnalysisCache() {
+        close();
+    }
+
+    bool open(const string &path, size_t megabytes, int flushSeconds) {
+    /**
+     * Maps the cache file, if there is one, and prepares the table for new results.
+     * An unreadable or foreign file is ignored and replaced at the next flush.
+
+     * @param path The cache file.
+     * @param megabytes The size of the file written by a flush.
+     * @param flushSeconds Seconds between background flushes, 0 to only flush on close.
+     * @return true once the cache is usable, even if the file didn't exist yet.
+     */
+        close();
+        this->path = path;
+        buckets = 1;
+        while ((buckets * 2) * ANALYSIS_BUCKET_SIZE * sizeof(AnalysisEntry) <= megabytes * 1024 * 1024) {
+            buckets *= 2;
+        }
+        pending.assign(buckets * ANALYSIS_BUCKET_SIZE, AnalysisEntry());
+        mapFile();
+
+        stopping = false;
+        if (flushSeconds > 0) {
+            flusher = thread([this, flushSeconds]() {
+                unique_lock<mutex> lock(flusherMutex);
+                while (!flusherWake.wait_for(lock, chrono::seconds(flushSeconds), [this]() { return stopping; })) {
+                    lock.unlock();
+                    flush();
+                    lock.lock();
+                }
+            });
+        }
+        return true;
+    }
+
+    bool isOpen() const {
+        return buckets > 0;
+    }
+
+    void close() {
+    /**
+     * Stops the background flushes, writes the remaining results and unmaps the file.
+     */
+        if (!isOpen()) {
+            return;
+        }
+        {
+            lock_guard<mutex> lock(flusherMutex);
+            stopping = true;
+        }
+        flusherWake.notify_all();
+        if (flusher.joinable()) {
+            flusher.join();
+        }
+        flush();
+        unmapFile();
+        pending.clear();
+        buckets = 0;
+    }
+
+    bool probe(uint64_t key, AnalysisEntry &found) {
+    /**
+     * Looks for a result in the file and among the results not written yet.
+     * Safe to call from any number of threads at once.
+
+     * @param key The canonical key of the position.
+     * @param[out] found The cached result.
+     * @return true if the position was found.
+     */
+        if (mappedEntries) {
+            const AnalysisEntry *bucket = mappedEntries + (key & (mappedBuckets - 1)) * ANALYSIS_BUCKET_SIZE;
+            for (int i = 0; i < ANALYSIS_BUCKET_SIZE; ++i) {
+                if (bucket[i].key == key && bucket[i].depth > 0) {
+                    found = bucket[i];
+                    return true;
+                }
+            }
+        }
+        lock_guard<mutex> lock(pendingMutex);
+        const AnalysisEntry *bucket = &pending[(key & (buckets - 1)) * ANALYSIS_BUCKET_SIZE];
+        for (int i = 0; i < ANALYSIS_BUCKET_SIZE; ++i) {
+            if (bucket[i].key == key && bucket[i].depth > 0) {
+                found = bucket[i];
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void record(const AnalysisEntry &entry) {
+    /**
+     * Keeps a result for the next flush. Safe to call from any number of threads at once.
+     */
+        lock_guard<mutex> lock(pendingMutex);
+        insert(pending, buckets, entry);
+        dirty = true;
+    }
+
+    bool flush() {
+    /**
+     * Merges the results recorded since the last flush into the file.
+     * The file on disk is read again under the writers' lock, so results other processes flushed in
+     * the meantime are kept. The merged table is written to a temporary file that replaces the old
+     * one with a rename, which readers that still map the old file don't notice.
+
+     * @return false if the file couldn't be written, the results are then kept for the next try.
+     */
+        if (!isOpen()) {
+            return false;
+        }
+        vector<AnalysisEntry> merged;
+        {
+            lock_guard<mutex> lock(pendingMutex);
+            if (!dirty) {
+                return true;
+            }
+            merged = pending;
+            dirty = false;
+        }
+
+        int lockFd = ::open((path + ".lock").c_str(), O_RDWR | O_CREAT, 0644);
+        if (lockFd < 0 || flock(lockFd, LOCK_EX) != 0) {
+            cerr << "Could not lock the analysis cache " << path << endl;
+            if (lockFd >= 0) {
+                ::close(lockFd);
+            }
+            return false;
+        }
+
+        // The newest results win ties, so the file's entries go in first and the new ones on top
+        vector<AnalysisEntry> table(buckets * ANALYSIS_BUCKET_SIZE, AnalysisEntry());
+        readFileInto(table);
+        for (const AnalysisEntry &entry : merged) {
+            if (entry.depth > 0) {
+                insert(table, buckets, entry);
+            }
+        }
+
+        string temporaryPath = path + ".tmp" + to_string(getpid());
+        FILE *file = fopen(temporaryPath.c_str(), "wb");
+        AnalysisCacheHeader header = {};
+        memcpy(header.magic, ANALYSIS_CACHE_MAGIC, sizeof(header.magic));
+        header.buckets = buckets;
+        bool written = file && fwrite(&header, sizeof(header), 1, file) == 1 &&
+                       fwrite(table.data(), sizeof(AnalysisEntry), table.size(), file) == table.size();
+        written = file && fclose(file) == 0 && written;
+        if (written) {
+            written = rename(temporaryPath.c_str(), path.c_str()) == 0;
+        }
+        if (!written) {
+            cerr << "Could not write the analysis cache " << path << endl;
+            remove(temporaryPath.c_str());
+        }
+        flock(lockFd, LOCK_UN);
+        ::close(lockFd);
+
+        if (!written) {
+            lock_guard<mutex> lock(pendingMutex);
+            dirty = true;
+        }
+        return written;
+    }
+
+private:
+    string path;
+    void *mapping;
+    size_t mappingBytes;
+    const AnalysisEntry *mappedEntries;
+    uint64_t mappedBuckets;
+    uint64_t buckets;
+    vector<AnalysisEntry> pending;
+    bool dirty;
+    mutex pendingMutex;
+    thread flusher;
+    mutex flusherMutex;
+    condition_variable flusherWake;
+    bool stopping;
+
+    static void insert(vector<AnalysisEntry> &table, uint64_t tableBuckets, const AnalysisEntry &entry) {
+    /**
+     * Puts an entry in its bucket: over the same position, or else over the shallowest entry.
+     * The same position is only replaced by a result at least as deep.
+     */
+        AnalysisEntry *bucket = &table[(entry.key & (tableBuckets - 1)) * ANALYSIS_BUCKET_SIZE];
+        AnalysisEntry *victim = bucket;
+        for (int i = 0; i < ANALYSIS_BUCKET_SIZE; ++i) {
+            if (bucket[i].key == entry.key && bucket[i].depth > 0) {
+                if (entry.depth >= bucket[i].depth) {
+                    bucket[i] = entry;
+                }
+                return;
+            }
+            if (bucket[i].depth < victim->depth) {
+                victim = &bucket[i];
+            }
+        }
+        if (entry.depth >= victim->depth) {
+            *victim = entry;
+        }
+    }
+
+    void mapFile() {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        struct stat info;
+        AnalysisCacheHeader header;
+        if (fstat(fd, &info) == 0 && pread(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header) &&
+            memcmp(header.magic, ANALYSIS_CACHE_MAGIC, sizeof(header.magic)) == 0 && header.buckets > 0 &&
+            (header.buckets & (header.buckets - 1)) == 0 &&
+            (size_t)info.st_size == sizeof(header) + header.buckets * ANALYSIS_BUCKET_SIZE * sizeof(AnalysisEntry)) {
+            void *address = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+            if (address != MAP_FAILED) {
+                mapping = address;
+                mappingBytes = info.st_size;
+                mappedEntries = reinterpret_cast<const AnalysisEntry *>(static_cast<const char *>(address) + sizeof(header));
+                mappedBuckets = header.buckets;
+            }
+        }
+        ::close(fd);
+    }
+
+    void unmapFile() {
+        if (mapping) {
+            munmap(mapping, mappingBytes);
+        }
+        mapping = nullptr;
+        mappingBytes = 0;
+        mappedEntries = nullptr;
+        mappedBuckets = 0;
+    }
+
+    void readFileInto(vector<AnalysisEntry> &table) {
+    /**
+     * Adds the entries of the file currently on disk to table, which may have a different size.
+     */
+        FILE *file = fopen(path.c_str(), "rb");
+        if (!file) {
+            return;
+        }
+        AnalysisCacheHeader header;
+        if (fread(&header, sizeof(header), 1, file) == 1 && memcmp(header.magic, ANALYSIS_CACHE_MAGIC, sizeof(header.magic)) == 0) {
+            AnalysisEntry entry;
+            for (uint64_t i = 0; i < header.buckets * ANALYSIS_BUCKET_SIZE && fread(&entry, sizeof(entry), 1, file) == 1; ++i) {
+                if (entry.depth > 0) {
+                    insert(table, buckets, entry);
+                }
+            }
+        }
+        fclose(file);
+    }
+};
+
+// The cache shared by all search threads, only used once it is opened
+AnalysisCache analysisCache;
+
+#endif // ANALYSISCACHE_H
@@ -0,0 +1,196 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <map>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "components.h"
+#include "display.h"
+#include "minimax.h"
+#include "expectimax.h"
+#include "position.h"
+
+// Analyzes a file of positions in the one-line notation of position.h, one per line, and writes one
+// result line per position in the same order. Positions are searched in parallel; a result that is
+// ready early waits until every position before it has been written.
+using namespace std;
+
+struct AnalyzeConfig {
+    string inputPath;     // - for standard input
+    string outputPath;    // - for standard output
+    int threads;
+    int maxDepth;
+    int moveTimeMs;       // 0 for no time limit
+    long long maxNodes;   // 0 for no node limit, otherwise the results are reproducible
+    bool searchCardDraws; // search with chance nodes over the card draws, as main.cpp does
+};
+
+// Positions read ahead of the oldest one not yet written, per thread. Bounds the memory a slow
+// position can hold up while the others finish.
+const size_t RESULTS_AHEAD_PER_THREAD = 64;
+
+string analyzePosition(const string &line, const AnalyzeConfig &config) {
+/**
+ * Searches one position and formats its result line, with the score from red's point of view:
+ * POSITION ; score S depth D move X1 Y1 X2 Y2 CARD nodes N ms T
+ * A line that isn't a valid position gets "INPUT ; error MESSAGE" instead.
+
+ * @return The result line, empty for a blank line or a # comment, which are skipped.
+ */
+    size_t first = line.find_first_not_of(" \t\r");
+    if (first == string::npos || line[first] == '#') {
+        return "";
+    }
+    Position position;
+    string error;
+    if (!parsePosition(line, position, error)) {
+        return line + " ; error " + error;
+    }
+
+    // Every position starts from an empty table, so its result doesn't depend on which positions the
+    // thread happened to search before it. A node-limited search clears it itself.
+    if (config.maxNodes == 0) {
+        clearTranspositionTable();
+    }
+    auto start = chrono::steady_clock::now();
+    SearchLimits limits = {config.maxDepth, config.moveTimeMs > 0 ? start + chrono::milliseconds(config.moveTimeMs)
+                                                                  : start + chrono::hours(24), config.maxNodes};
+    SearchResult result;
+    if (config.searchCardDraws) {
+        vector<MoveCard> deck;
+        for (const MoveCard &card : FullDeck) {
+            if (!(card == position.redMoveCards[0] || card == position.redMoveCards[1] ||
+                  card == position.blueMoveCards[0] || card == position.blueMoveCards[1])) {
+                deck.push_back(card);
+            }
+        }
+        result = expectimaxSearch(position.state, limits, position.redMoveCards, position.blueMoveCards, deck);
+    } else {
+        result = iterativeDeepening(position.state, limits, position.redMoveCards, position.blueMoveCards);
+    }
+    double elapsedMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    ostringstream text;
+    text << formatPosition(position) << " ; score " << result.score << " depth " << result.depth << " move ";
+    if (result.bestMove.x1 >= 0) {
+        text << result.bestMove.x1 << " " << result.bestMove.y1 << " " << result.bestMove.x2 << " "
+             << result.bestMove.y2 << " " << result.bestMove.usedCard.name;
+    } else {
+        text << "none";
+    }
+    text << " nodes " << result.nodes << " ms " << (long long)elapsedMs;
+    return text.str();
+}
+
+void parseAnalyzeOptions(int argc, char *argv[], AnalyzeConfig &config) {
+/**
+ * Reads the batch analysis options from the command line.
+ *
+ * Supported options: --in FILE, --out FILE, --threads N, --depth N, --ms N, --nodes N, --expectimax,
+ * --nnue FILE
+ */
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--in" && i + 1 < argc) {
+            config.inputPath = argv[++i];
+        } else if (arg == "--out" && i + 1 < argc) {
+            config.outputPath = argv[++i];
+        } else if (arg == "--threads" && i + 1 < argc) {
+            config.threads = max(1, stoi(argv[++i]));
+        } else if (arg == "--depth" && i + 1 < argc) {
+            config.maxDepth = max(1, min(MAX_PLY, stoi(argv[++i])));
+        } else if (arg == "--ms" && i + 1 < argc) {
+            config.moveTimeMs = max(0, stoi(argv[++i]));
+        } else if (arg == "--nodes" && i + 1 < argc) {
+            config.maxNodes = max(0LL, stoll(argv[++i]));
+        } else if (arg == "--expectimax") {
+            config.searchCardDraws = true;
+        } else if (arg == "--nnue" && i + 1 < argc) {
+            searchOptions.neuralEvaluation = loadNetwork(argv[++i]);
+        } else {
+            cerr << "Unknown option: " << arg << endl;
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    AnalyzeConfig config = {"-", "-", (int)max(1u, thread::hardware_concurrency()), MAX_PLY, 1000, 0, false};
+    parseAnalyzeOptions(argc, argv, config);
+
+    ifstream inputFile;
+    if (config.inputPath != "-") {
+        inputFile.open(config.inputPath);
+        if (!inputFile) {
+            cerr << "Could not open " << config.inputPath << endl;
+            return 1;
+        }
+    }
+    ofstream outputFile;
+    if (config.outputPath != "-") {
+        outputFile.open(config.outputPath);
+        if (!outputFile) {
+            cerr << "Could not open " << config.outputPath << endl;
+            return 1;
+        }
+    }
+    istream &input = (config.inputPath != "-") ? static_cast<istream &>(inputFile) : cin;
+    ostream &output = (config.outputPath != "-") ? static_cast<ostream &>(outputFile) : cout;
+
+    // Workers read the next line and number it under the lock, search it without the lock, then hand
+    // in the result. Whoever hands in the oldest missing result writes it and every result after it
+    // that is already done. A worker waits before reading when it would get too far ahead.
+    mutex queueMutex;
+    condition_variable resultWritten;
+    size_t nextRead = 0;
+    size_t nextWrite = 0;
+    size_t analyzed = 0;
+    map<size_t, string> finished;
+    size_t resultsAhead = RESULTS_AHEAD_PER_THREAD * config.threads;
+    auto batchStart = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (int i = 0; i < config.threads; ++i) {
+        workers.emplace_back([&]() {
+            // Allocated up front so the first position's time limit isn't spent on it
+            resizeTranspositionTable(TRANSPOSITION_TABLE_MEGABYTES);
+            string line;
+            unique_lock<mutex> lock(queueMutex);
+            while (true) {
+                resultWritten.wait(lock, [&]() { return nextRead < nextWrite + resultsAhead; });
+                if (!getline(input, line)) {
+                    break;
+                }
+                size_t index = nextRead++;
+                lock.unlock();
+                string result = analyzePosition(line, config);
+                lock.lock();
+
+                finished[index] = result;
+                bool written = false;
+                for (auto next = finished.find(nextWrite); next != finished.end(); next = finished.find(nextWrite)) {
+                    if (!next->second.empty()) {
+                        output << next->second << '\n';
+                        ++analyzed;
+                    }
+                    finished.erase(next);
+                    ++nextWrite;
+                    written = true;
+                }
+                if (written) {
+                    output.flush();
+                    resultWritten.notify_all();
+                }
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - batchStart).count();
+    cerr << "Analyzed " << analyzed << " positions in " << seconds << " s on " << config.threads << " threads" << endl;
+    return 0;
+}
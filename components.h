@@ -6,6 +6,8 @@ using namespace std;
 
 #include <string>
 #include <vector>
+#include <algorithm>
+#include <cstdint>
 
 const int BOARD_SIZE = 5;
 const int MAX_DEPTH = 5;
@@ -28,14 +30,17 @@ MoveCard Goose = {"Goose",{-1, -1, 1, 1}, {0, 1, 0, -1}, 4};
 MoveCard Rooster = {"Rooster",{-1, -1, 1, 1}, {0, -1, 0, 1}, 4};
 MoveCard Monkey = {"Monkey",{-1, 1, -1, 1}, {1, 1, -1, -1}, 4};
 MoveCard Mantis = {"Manits",{-1, 0, 1}, {1, -1, 1}, 3};
-MoveCard Horse = {"Horse",{-1, 0, 0}, {0, 1, 1}, 3};
-MoveCard Ox = {"Ox",{0, 0, 1}, {1, -1, 1}, 3};
+MoveCard Horse = {"Horse",{-1, 0, 0}, {0, 1, -1}, 3};
+MoveCard Ox = {"Ox",{0, 0, 1}, {1, -1, 0}, 3};
 MoveCard Crane = {"Crane",{0, -1, 1}, {1, -1, -1}, 3};
 MoveCard Boar = {"Boar",{-1, 0, 1}, {0, 1, 0}, 3};
 MoveCard Eel = {"Eel",{-1, -1, 1}, {1, -1, 0}, 3};
 MoveCard Cobra = {"Cobra",{-1, 1, 1}, {0, 1, -1}, 3};
 
-vector<MoveCard> Deck = {Tiger, Dragon, Frog, Rabbit, Crab, Elephant, Goose, Rooster, Monkey, Mantis, Horse, Ox, Crane, Boar, Eel, Cobra};
+const vector<MoveCard> FullDeck = {Tiger, Dragon, Frog, Rabbit, Crab, Elephant, Goose, Rooster, Monkey, Mantis, Horse, Ox, Crane, Boar, Eel, Cobra};
+const int DECK_SIZE = 16;
+
+vector<MoveCard> Deck = FullDeck;
 
 enum Piece { EMPTY, RED_MASTER, RED_STUDENT, BLUE_MASTER, BLUE_STUDENT };
 enum Player { RED, BLUE, NONE };
@@ -63,18 +68,47 @@ bool operator==(const MoveCard& lhs, const MoveCard& rhs) {
 //     return lhs == rhs.name;
 // }
 
+// Position of the card in FullDeck, which gives every card a small fixed number
+int cardIndex(const MoveCard &card) {
+    for (int i = 0; i < DECK_SIZE; ++i) {
+        if (FullDeck[i] == card) {
+            return i;
+        }
+    }
+    return -1;
+}
+
 ostream& operator<<( ostream &os, const MoveCard &moveCard) {
     os << moveCard.name;
     return os;
 }
 
+template <typename RandomEngine>
+int randomBelow(int bound, RandomEngine &random_engine) {
+/**
+ * @brief Draws a number in [0, bound) that only depends on the engine's output.
+ *
+ * uniform_int_distribution and shuffle are free to differ between standard libraries, so a seed would
+ * not deal the same cards everywhere. Raw values past the largest multiple of bound are drawn again,
+ * which keeps every result equally likely. The engine must produce at most 32 bits, like mt19937.
+ */
+    uint64_t range = (uint64_t)(random_engine.max() - random_engine.min()) + 1;
+    uint64_t limit = range - range % bound;
+    uint64_t value;
+    do {
+        value = (uint64_t)(random_engine() - random_engine.min());
+    } while (value >= limit);
+    return (int)(value % bound);
+}
+
 template <typename RandomEngine>
 void generateUniqueRandomIndices(int range, vector<int> &randomIndices, RandomEngine& random_engine) {
 /**
  * @brief Generates a vector of unique random indices within a specified range.
  * 
  * This function populates a vector with unique random indices ranging from 0 to range-1.
- * The indices are then shuffled using the provided random engine to ensure uniqueness.
+ * The indices are then shuffled with a Fisher-Yates shuffle driven by the provided random engine,
+ * which gives the same order for the same seed on every platform.
  * This is typically used for sampling without replacement from a larger dataset.
  * 
  * @param range The range of indices to generate (0 to range-1).
@@ -85,7 +119,41 @@ void generateUniqueRandomIndices(int range, vector<int> &randomIndices, RandomEn
         randomIndices.push_back(i);
     }
 
-    shuffle(randomIndices.begin(), randomIndices.end(), random_engine);
+    for (int i = (int)randomIndices.size() - 1; i > 0; --i) {
+        swap(randomIndices[i], randomIndices[randomBelow(i + 1, random_engine)]);
+    }
+}
+
+template <typename RandomEngine>
+void replaceUsedCard(vector<MoveCard> &deck, MoveCard *moveCards, const MoveCard &usedCard, RandomEngine& random_engine) {
+/**
+ * @brief Takes the card a player just used out of the game deck and deals them a new one.
+ * 
+ * The used card is removed from the deck, the deck is refilled once it runs out, and the
+ * hand slot that held the used card receives a card drawn at random from the deck.
+ * 
+ * @param[in,out] deck The running game deck.
+ * @param[in,out] moveCards The two cards in the hand of the player who moved.
+ * @param usedCard The card that was used for the move.
+ * @param random_engine The random engine used to draw the new card.
+ */
+    // Remove value equlivalent to usedCard from the deck
+    deck.erase( remove_if(deck.begin(), deck.end(), [&usedCard](const MoveCard &card) {
+        return card == usedCard;
+
+    }), deck.end());
+
+    // if the deck is empty refill it
+    if (deck.size() == 0){
+        deck = FullDeck;
+    }
+
+    vector<int> nextCardIndices;
+    generateUniqueRandomIndices(deck.size(), nextCardIndices, random_engine);
+
+    // grab index of usedCard in moveCards
+    int usedCardIndex = (moveCards[0] == usedCard) ? 0 : 1;
+    moveCards[usedCardIndex] = deck[nextCardIndices[0]];
 }
 
 #endif // COMPONENTS_H
\ No newline at end of file
@@ -53,6 +53,19 @@ Move parseMoveInput(const string& input) {
     return move;
 }
 
+string formatMove(const Move& move) {
+/**
+ * Writes a move the way parseMoveInput reads it, followed by the card it uses.
+ * A pass, stored as a move with x1 = -1, is written as "pass".
+ */
+    if (move.x1 < 0) {
+        return "pass";
+    }
+    ostringstream ss;
+    ss << "(" << move.x1 << "," << move.y1 << ") -> (" << move.x2 << "," << move.y2 << ") " << move.usedCard.name;
+    return ss.str();
+}
+
 void printBoard(const  vector< vector<Piece>> &board) {
 /**
  * Prints the Onitama board game state in a human-readable format.
@@ -0,0 +1,445 @@
+#ifndef EXPECTIMAX_H
+#define EXPECTIMAX_H
+
+#include <iostream>
+using namespace std;
+
+#include <cstdint>
+#include <vector>
+#include <chrono>
+#include <limits>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include "components.h"
+#include "hashing.h"
+#include "minimax.h"
+
+// Expectimax search over the random card draws.
+//
+// After every move the used card leaves the deck and the mover's empty hand slot is filled with a
+// card drawn at random from the deck, which is refilled once it runs out. miniMaxAlphaBeta keeps
+// the hands fixed; here every move is followed by a chance node that averages over all cards that
+// can be drawn. Chance nodes are pruned with Star1 bounds and Star2 probing (Ballard's *-minimax),
+// and both kinds of node are cached in the transposition table.
+
+// Bounds on any score the search can return, needed to bound the average of unsearched draws
+const int EXPECTIMAX_LOWER = -WIN_SCORE;
+const int EXPECTIMAX_UPPER = WIN_SCORE;
+
+uint16_t deckMask(const vector<MoveCard> &deck) {
+/**
+ * Converts the running game deck into a bit mask over FullDeck, bit i set when card i can be drawn.
+ */
+    uint16_t mask = 0;
+    for (const MoveCard &card : deck) {
+        mask |= 1 << cardIndex(card);
+    }
+    return mask;
+}
+
+uint64_t expectimaxKey(const GameState &state, const int *redCards, const int *blueCards, uint16_t deck, int drawSlot, bool *mirrored) {
+/**
+ * Computes the canonical key of an expectimax node. Besides the board and the hands it covers the
+ * deck, since the cards that can still be drawn change the value of the position.
+ * At a chance node the card in drawSlot has already been used and is left out of the key.
+
+ * @param state The position, currentPlayer is the side to move or, at a chance node, the side that just moved.
+ * @param redCards The red player's cards as FullDeck indices.
+ * @param blueCards The blue player's cards as FullDeck indices.
+ * @param deck The cards that can be drawn.
+ * @param drawSlot The hand slot waiting for a card at a chance node, -1 at a decision node.
+ * @param[out] mirrored Set to true when the key is the one of the mirrored position.
+ * @return The 64-bit key of the node.
+ */
+    KeyPair keys = boardKeys(state);
+    for (int i = 0; i < 2; ++i) {
+        if (!(state.currentPlayer == RED && drawSlot == i)) {
+            addCardKey(keys, Zobrist.redCard, redCards[i]);
+        }
+        if (!(state.currentPlayer == BLUE && drawSlot == i)) {
+            addCardKey(keys, Zobrist.blueCard, blueCards[i]);
+        }
+    }
+    for (int card = 0; card < DECK_SIZE; ++card) {
+        if (deck & (1 << card)) {
+            addCardKey(keys, Zobrist.deckCard, card);
+        }
+    }
+    uint64_t key = canonicalKey(keys, mirrored);
+    // Chance nodes and decision nodes with the same cards must not share an entry
+    return (drawSlot >= 0) ? ~key : key;
+}
+
+int expectimaxChance(GameState &state, int *redCards, int *blueCards, int drawSlot, uint16_t deck, int depth, int alpha, int beta, int ply);
+
+int expectimaxDecision(GameState &state, int *redCards, int *blueCards, uint16_t deck, int depth, int alpha, int beta, int ply,
+                       Move &bestMove, bool probeOnly = false) {
+/**
+ * Searches a node where a player chooses a move. Works like miniMaxAlphaBeta, except that every
+ * move leads to a chance node for the card that replaces the used one. Null moves and late move
+ * reductions are not used, their assumptions don't hold once scores are averages.
+
+ * @param state The position, with currentPlayer set to the side to move.
+ * @param redCards The red player's cards as FullDeck indices.
+ * @param blueCards The blue player's cards as FullDeck indices.
+ * @param deck The cards that can be drawn.
+ * @param depth The remaining search depth in moves.
+ * @param alpha The current best value for the maximizing player.
+ * @param beta The current best value for the minimizing player.
+ * @param ply The number of moves played from the root of the search.
+ * @param bestMove Set to the best move found.
+ * @param probeOnly If true only the first move in the search order is searched, which gives a bound
+ * on the node's value for Star2 probing. Probe results are not stored.
+ * @return The score of the node from the red player's point of view.
+ */
+    searchStats.nodes++;
+    if (searchInterrupted()) {
+        return 0;
+    }
+
+    if (state.winner != NONE) {
+        return winScore(state.winner, ply);
+    }
+
+    MoveCard redMoveCards[2] = {FullDeck[redCards[0]], FullDeck[redCards[1]]};
+    MoveCard blueMoveCards[2] = {FullDeck[blueCards[0]], FullDeck[blueCards[1]]};
+    if (depth == 0) {
+        // The hands change at every draw, so the network accumulator is built from scratch here
+        if (searchOptions.neuralEvaluation) {
+            NnueAccumulator accumulator;
+            refreshAccumulator(accumulator, state, redMoveCards, blueMoveCards, state.currentPlayer);
+            return networkScore(accumulator);
+        }
+        return evaluate(state, redMoveCards, blueMoveCards);
+    }
+
+    bool maximizingPlayer = state.currentPlayer == RED;
+    int alphaOrig = alpha;
+    int betaOrig = beta;
+    bool mirrored = false;
+    uint64_t key = 0;
+    bool hasHashMove = false;
+    Move hashMove;
+    if (searchOptions.transpositionTable) {
+        key = expectimaxKey(state, redCards, blueCards, deck, -1, &mirrored);
+        const TranspositionEntry *entry = probeTranspositionTable(key);
+        if (entry) {
+            int score = scoreFromTransposition(entry->score, ply);
+            if (ply > 0 && entry->depth >= depth &&
+                (entry->bound == EXACT_BOUND || (entry->bound == LOWER_BOUND && score >= beta) ||
+                 (entry->bound == UPPER_BOUND && score <= alpha))) {
+                return score;
+            }
+            // Below the root the draws make the previous best move a poor guess, captures do better
+            if (ply == 0 && entry->card >= 0) {
+                hashMove.x1 = entry->x1;
+                hashMove.y1 = entry->y1;
+                hashMove.x2 = entry->x2;
+                hashMove.y2 = entry->y2;
+                hashMove.usedCard = FullDeck[entry->card];
+                if (mirrored) {
+                    hashMove = mirrorMove(hashMove);
+                }
+                hasHashMove = true;
+            }
+        }
+    }
+
+    generateLegalMoves(state, redMoveCards, blueMoveCards);
+    vector<Move> orderedMoves = maximizingPlayer ? state.redLegalMoves : state.blueLegalMoves;
+
+    for (const auto &move : orderedMoves) {
+        if (winnerOfMove(state, move) != NONE) {
+            bestMove = move;
+            return winScore(state.currentPlayer, ply + 1);
+        }
+    }
+
+    // A player without a legal move passes the turn, nobody draws a card
+    if (orderedMoves.empty()) {
+        GameState nextState = state;
+        nextState.currentPlayer = maximizingPlayer ? BLUE : RED;
+        Move dummyMove;
+        return expectimaxDecision(nextState, redCards, blueCards, deck, depth - 1, alpha, beta, ply + 1, dummyMove);
+    }
+
+    stable_partition(orderedMoves.begin(), orderedMoves.end(), [&state](const Move &move) {
+        return isCapture(state, move);
+    });
+    if (hasHashMove) {
+        auto found = find_if(orderedMoves.begin(), orderedMoves.end(), [&hashMove](const Move &move) {
+            return move.x1 == hashMove.x1 && move.y1 == hashMove.y1 && move.x2 == hashMove.x2 &&
+                   move.y2 == hashMove.y2 && move.usedCard == hashMove.usedCard;
+        });
+        if (found != orderedMoves.end()) {
+            rotate(orderedMoves.begin(), found, found + 1);
+        }
+    }
+    if (probeOnly) {
+        orderedMoves.resize(1);
+    }
+
+    int bestEval = maximizingPlayer ? numeric_limits<int>::min() : numeric_limits<int>::max();
+    for (size_t moveIdx = 0; moveIdx < orderedMoves.size(); ++moveIdx) {
+        TRACE_SPAN_IF(ply == 0, "root move", moveIdx);
+        const Move &move = orderedMoves[moveIdx];
+        GameState nextState = state;
+        applyMove(nextState, move, redMoveCards, blueMoveCards);
+
+        // The used card leaves the deck, which is refilled once it runs out
+        int *moverCards = maximizingPlayer ? redCards : blueCards;
+        int usedCard = cardIndex(move.usedCard);
+        int drawSlot = (moverCards[0] == usedCard) ? 0 : 1;
+        uint16_t nextDeck = deck & ~(1 << usedCard);
+        if (nextDeck == 0) {
+            nextDeck = (1 << DECK_SIZE) - 1;
+        }
+        int nextRedCards[2] = {redCards[0], redCards[1]};
+        int nextBlueCards[2] = {blueCards[0], blueCards[1]};
+
+        int eval = expectimaxChance(nextState, nextRedCards, nextBlueCards, drawSlot, nextDeck, depth - 1, alpha, beta, ply + 1);
+        if (searchControl.aborted) {
+            return 0;
+        }
+        if (maximizingPlayer ? eval > bestEval : eval < bestEval) {
+            bestEval = eval;
+            bestMove = move;
+        }
+        if (maximizingPlayer) {
+            alpha = max(alpha, eval);
+        } else {
+            beta = min(beta, eval);
+        }
+        if (beta <= alpha) {
+            break;
+        }
+    }
+
+    if (searchOptions.transpositionTable && !probeOnly) {
+        BoundType bound = (bestEval <= alphaOrig) ? UPPER_BOUND : (bestEval >= betaOrig) ? LOWER_BOUND : EXACT_BOUND;
+        storeTransposition(key, depth, bestEval, bound, bestMove, mirrored, ply);
+    }
+    return bestEval;
+}
+
+int expectimaxChance(GameState &state, int *redCards, int *blueCards, int drawSlot, uint16_t deck, int depth, int alpha, int beta, int ply) {
+/**
+ * Searches a chance node: the player who just moved draws one of the cards in the deck into
+ * drawSlot, each with the same probability, and the value is the average over the draws.
+ * Every score lies between EXPECTIMAX_LOWER and EXPECTIMAX_UPPER, so after some draws are searched
+ * the average can be bounded before the rest are (Star1). The window of each draw is narrowed to
+ * the values that can still move the average across alpha or beta, and the node is cut as soon as
+ * the bounds settle it. Before that every draw is probed by searching only its first move (Star2),
+ * which bounds the draw from the side of the player to move next and often cuts the node at once.
+
+ * @param state The position after the move, currentPlayer is still the player who moved.
+ * @param redCards The red player's cards as FullDeck indices.
+ * @param blueCards The blue player's cards as FullDeck indices.
+ * @param drawSlot The slot of the mover's hand that receives the drawn card.
+ * @param deck The cards that can be drawn, the used card already taken out.
+ * @param depth The remaining search depth in moves.
+ * @param alpha The current best value for the maximizing player.
+ * @param beta The current best value for the minimizing player.
+ * @param ply The number of moves played from the root of the search.
+ * @return The expected score from the red player's point of view. When the average was proven
+ * to lie outside the window, a bound on it that lies outside the window as well.
+ */
+    searchStats.nodes++;
+    if (searchInterrupted()) {
+        return 0;
+    }
+
+    // Nothing is drawn after the game has ended
+    if (state.winner != NONE) {
+        return winScore(state.winner, ply);
+    }
+
+    bool mirrored = false;
+    uint64_t key = 0;
+    if (searchOptions.transpositionTable) {
+        key = expectimaxKey(state, redCards, blueCards, deck, drawSlot, &mirrored);
+        const TranspositionEntry *entry = probeTranspositionTable(key);
+        if (entry) {
+            int score = scoreFromTransposition(entry->score, ply);
+            if (entry->depth >= depth &&
+                (entry->bound == EXACT_BOUND || (entry->bound == LOWER_BOUND && score >= beta) ||
+                 (entry->bound == UPPER_BOUND && score <= alpha))) {
+                return score;
+            }
+        }
+    }
+
+    // The board is the same after every draw, only the mover's hand differs
+    Player mover = state.currentPlayer;
+    GameState nextState = state;
+    nextState.currentPlayer = (mover == RED) ? BLUE : RED;
+    bool nextMaximizes = nextState.currentPlayer == RED;
+    vector<int> outcomeCards;
+    for (int card = 0; card < DECK_SIZE; ++card) {
+        if (deck & (1 << card)) {
+            outcomeCards.push_back(card);
+        }
+    }
+    long long count = outcomeCards.size();
+
+    // lower[i] and upper[i] bound the value of draw i, they meet once the draw is searched
+    vector<long long> lower(count, EXPECTIMAX_LOWER);
+    vector<long long> upper(count, EXPECTIMAX_UPPER);
+    long long lowerSum = count * EXPECTIMAX_LOWER;
+    long long upperSum = count * EXPECTIMAX_UPPER;
+    // The average lies outside the window once the sum passes these
+    long long alphaSum = count * (long long)alpha;
+    long long betaSum = count * (long long)beta;
+
+    auto searchDraw = [&](size_t i, bool probe) {
+        int nextRedCards[2] = {redCards[0], redCards[1]};
+        int nextBlueCards[2] = {blueCards[0], blueCards[1]};
+        (mover == RED ? nextRedCards : nextBlueCards)[drawSlot] = outcomeCards[i];
+
+        // The window that still decides the outcome, given the bounds on the other draws
+        long long drawAlpha = alphaSum - (upperSum - upper[i]);
+        long long drawBeta = betaSum - (lowerSum - lower[i]);
+        int childAlpha = (int)max<long long>(drawAlpha, EXPECTIMAX_LOWER - 1);
+        int childBeta = (int)min<long long>(drawBeta, EXPECTIMAX_UPPER + 1);
+
+        Move dummyMove;
+        int eval = expectimaxDecision(nextState, nextRedCards, nextBlueCards, deck, depth, childAlpha, childBeta, ply, dummyMove, probe);
+        if (searchControl.aborted) {
+            return;
+        }
+
+        // A probe only searched one move, which bounds the draw from the side of the player to move
+        bool exact = eval > childAlpha && eval < childBeta;
+        if (probe) {
+            if (nextMaximizes && eval > childAlpha) {
+                lowerSum += eval - lower[i];
+                lower[i] = eval;
+            } else if (!nextMaximizes && eval < childBeta) {
+                upperSum += eval - upper[i];
+                upper[i] = eval;
+            }
+        } else if (exact) {
+            lowerSum += eval - lower[i];
+            upperSum += eval - upper[i];
+            lower[i] = upper[i] = eval;
+        } else if (eval <= childAlpha) {
+            upperSum += min<long long>(eval, upper[i]) - upper[i];
+            upper[i] = min<long long>(eval, upper[i]);
+        } else {
+            lowerSum += max<long long>(eval, lower[i]) - lower[i];
+            lower[i] = max<long long>(eval, lower[i]);
+        }
+    };
+
+    bool settled = false;
+    // Star2: probe every draw once, unless the bounds already settle the node
+    if (depth > 0) {
+        for (size_t i = 0; i < (size_t)count && !settled; ++i) {
+            searchDraw(i, true);
+            if (searchControl.aborted) {
+                return 0;
+            }
+            settled = upperSum <= alphaSum || lowerSum >= betaSum;
+        }
+    }
+    // Star1: search the draws fully, each with the narrowest window that can still matter
+    for (size_t i = 0; i < (size_t)count && !settled; ++i) {
+        searchDraw(i, false);
+        if (searchControl.aborted) {
+            return 0;
+        }
+        settled = upperSum <= alphaSum || lowerSum >= betaSum;
+    }
+
+    // Every draw is exact unless a bound settled the node, then the nearer bound is returned
+    long long sum = (upperSum <= alphaSum) ? upperSum : lowerSum;
+    double average = (double)sum / count;
+    int result = (int)(average < 0 ? average - 0.5 : average + 0.5);
+
+    if (searchOptions.transpositionTable && depth > 0) {
+        BoundType bound = (upperSum <= alphaSum) ? UPPER_BOUND : (lowerSum >= betaSum) ? LOWER_BOUND : EXACT_BOUND;
+        Move noMove = {};
+        noMove.x1 = -1;
+        storeTransposition(key, depth, result, bound, noMove, false, ply);
+    }
+    return result;
+}
+
+SearchResult expectimaxSearch(GameState state, const SearchLimits &limits, MoveCard *redMoveCards, MoveCard *blueMoveCards,
+                              const vector<MoveCard> &deck, const atomic<bool> *stopFlag = nullptr,
+                              const function<void(const SearchResult &)> &onIteration = nullptr) {
+/**
+ * Iterative deepening over expectimaxDecision, with the same limits and stop rules as
+ * iterativeDeepening. Use it when the deck matters: the scores are expected values over every
+ * card that can be drawn after each move.
+
+ * @param state The position to search, with currentPlayer set to the side to move.
+ * @param limits The deepest iteration to run and the time by which the search has to return.
+ * @param redMoveCards A pointer to an array of MoveCard objects for the red player.
+ * @param blueMoveCards A pointer to an array of MoveCard objects for the blue player.
+ * @param deck The running game deck the next cards are drawn from.
+ * @param stopFlag If given, the search stops soon after the flag becomes true.
+ * @param onIteration If given, called with the result after every completed iteration.
+ * @return The best move, its expected score, the completed depth and the number of nodes searched.
+ */
+    const int ITERATION_GROWTH = 6;
+
+    SearchResult result = {};
+    result.bestMove.x1 = -1;
+    armSearch(limits, stopFlag);
+
+    int redCards[2] = {cardIndex(redMoveCards[0]), cardIndex(redMoveCards[1])};
+    int blueCards[2] = {cardIndex(blueMoveCards[0]), cardIndex(blueMoveCards[1])};
+    uint16_t mask = deckMask(deck);
+
+    for (int depth = 1; depth <= limits.maxDepth; ++depth) {
+        TRACE_SPAN_VALUE("iteration", depth);
+        auto iterationStart = chrono::steady_clock::now();
+        if (depth > 1 && searchControl.hasDeadline && iterationStart >= limits.deadline) {
+            break;
+        }
+
+        Move bestMove;
+        bestMove.x1 = -1;
+        int score = expectimaxDecision(state, redCards, blueCards, mask, depth, numeric_limits<int>::min(), numeric_limits<int>::max(), 0, bestMove);
+
+        if (searchControl.aborted) {
+            if (bestMove.x1 >= 0 && (searchOptions.transpositionTable || result.bestMove.x1 < 0)) {
+                result.bestMove = bestMove;
+            }
+            break;
+        }
+
+        result.bestMove = bestMove;
+        result.score = score;
+        result.depth = depth;
+        if (onIteration) {
+            result.nodes = searchStats.nodes;
+            onIteration(result);
+        }
+
+        if (abs(score) >= WIN_SCORE - MAX_PLY) {
+            break;
+        }
+
+        auto iterationEnd = chrono::steady_clock::now();
+        if (searchControl.hasDeadline && iterationEnd + (iterationEnd - iterationStart) * ITERATION_GROWTH >= limits.deadline) {
+            break;
+        }
+    }
+
+    if (result.bestMove.x1 < 0) {
+        generateLegalMoves(state, redMoveCards, blueMoveCards);
+        const vector<Move> &legalMoves = (state.currentPlayer == RED) ? state.redLegalMoves : state.blueLegalMoves;
+        if (!legalMoves.empty()) {
+            result.bestMove = legalMoves[0];
+        }
+    }
+
+    searchControl = {nullptr, false, {}, false, 0};
+    result.nodes = searchStats.nodes;
+    return result;
+}
+
+#endif // EXPECTIMAX_H
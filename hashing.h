@@ -0,0 +1,172 @@
+#ifndef HASHING_H
+#define HASHING_H
+
+#include <iostream>
+using namespace std;
+
+#include <cstdint>
+#include <random>
+#include "components.h"
+
+// Random 64-bit keys for Zobrist hashing. A position key is the XOR of the keys of everything in
+// the position, so the same position always gets the same key no matter how it was reached.
+struct ZobristKeys {
+    uint64_t piece[5][BOARD_SIZE * BOARD_SIZE];
+    uint64_t redCard[DECK_SIZE];
+    uint64_t blueCard[DECK_SIZE];
+    uint64_t deckCard[DECK_SIZE];
+    uint64_t blueToMove;
+
+    ZobristKeys() {
+        // Fixed seed so keys are the same in every run
+        mt19937_64 random_engine(0x4f6e6974616d61ULL);
+        for (int piece = 0; piece < 5; ++piece) {
+            for (int square = 0; square < BOARD_SIZE * BOARD_SIZE; ++square) {
+                this->piece[piece][square] = (piece == EMPTY) ? 0 : random_engine();
+            }
+        }
+        for (int card = 0; card < DECK_SIZE; ++card) {
+            redCard[card] = random_engine();
+            blueCard[card] = random_engine();
+            deckCard[card] = random_engine();
+        }
+        blueToMove = random_engine();
+    }
+};
+
+const ZobristKeys Zobrist;
+
+// For every card, the card whose moves are its moves reflected left to right (some cards are
+// their own mirror). -1 if the deck has no such card.
+struct CardMirrors {
+    int of[DECK_SIZE];
+
+    CardMirrors() {
+        for (int card = 0; card < DECK_SIZE; ++card) {
+            of[card] = -1;
+            for (int other = 0; other < DECK_SIZE && of[card] < 0; ++other) {
+                if (FullDeck[card].numMoves != FullDeck[other].numMoves) {
+                    continue;
+                }
+                bool matches = true;
+                for (int i = 0; i < FullDeck[card].numMoves && matches; ++i) {
+                    bool found = false;
+                    for (int j = 0; j < FullDeck[other].numMoves; ++j) {
+                        if (FullDeck[card].dx[i] == -FullDeck[other].dx[j] && FullDeck[card].dy[i] == FullDeck[other].dy[j]) {
+                            found = true;
+                        }
+                    }
+                    matches = found;
+                }
+                if (matches) {
+                    of[card] = other;
+                }
+            }
+        }
+    }
+};
+
+const CardMirrors CardMirror;
+
+// Zobrist key of a position and of the same position reflected left to right (x -> 4 - x, every
+// card replaced by its mirror card). Both are built up together so the canonical key costs one pass.
+struct KeyPair {
+    uint64_t key;
+    uint64_t mirrored;
+    bool mirrorable;
+};
+
+KeyPair boardKeys(const GameState &state) {
+/**
+ * Computes the Zobrist keys of the pieces on the board and the side to move, as seen directly and
+ * reflected left to right.
+ *
+ * @param state The game state to hash.
+ * @return The direct and the mirrored key.
+ */
+    KeyPair keys = {0, 0, true};
+    for (int x = 0; x < BOARD_SIZE; ++x) {
+        for (int y = 0; y < BOARD_SIZE; ++y) {
+            Piece piece = state.board[x][y];
+            keys.key ^= Zobrist.piece[piece][x * BOARD_SIZE + y];
+            keys.mirrored ^= Zobrist.piece[piece][(BOARD_SIZE - 1 - x) * BOARD_SIZE + y];
+        }
+    }
+    if (state.currentPlayer == BLUE) {
+        keys.key ^= Zobrist.blueToMove;
+        keys.mirrored ^= Zobrist.blueToMove;
+    }
+    return keys;
+}
+
+void addCardKey(KeyPair &keys, const uint64_t *cardKeys, int card) {
+    keys.key ^= cardKeys[card];
+    if (CardMirror.of[card] < 0) {
+        keys.mirrorable = false;
+    } else {
+        keys.mirrored ^= cardKeys[CardMirror.of[card]];
+    }
+}
+
+uint64_t canonicalKey(const KeyPair &keys, bool *mirrored = nullptr) {
+/**
+ * Picks the canonical one of a position's two keys, so a position and its mirror image share it.
+ *
+ * @param keys The direct and mirrored key of the position.
+ * @param[out] mirrored If given, set to true when the mirrored key was chosen, meaning moves stored
+ * under the key have to be reflected back before they are played in this position.
+ * @return The smaller of the two keys.
+ */
+    bool useMirror = keys.mirrorable && keys.mirrored < keys.key;
+    if (mirrored) {
+        *mirrored = useMirror;
+    }
+    return useMirror ? keys.mirrored : keys.key;
+}
+
+uint64_t boardKey(const GameState &state) {
+/**
+ * Computes the Zobrist key of the pieces on the board and the side to move.
+ *
+ * @param state The game state to hash.
+ * @return The XOR of the keys of every piece on its square, plus blueToMove if blue is to move.
+ */
+    return boardKeys(state).key;
+}
+
+uint64_t positionKey(const GameState &state, MoveCard *redMoveCards, MoveCard *blueMoveCards, bool *mirrored = nullptr) {
+/**
+ * Computes the canonical Zobrist key of a position: the board, the side to move and both hands.
+ * The order of the two cards within a hand doesn't change the key, and a position reflected left
+ * to right with mirrored cards gets the same key as the original.
+ *
+ * @param state The game state to hash.
+ * @param redMoveCards A pointer to an array of the red player's two MoveCards.
+ * @param blueMoveCards A pointer to an array of the blue player's two MoveCards.
+ * @param[out] mirrored If given, set to true when the key is the one of the mirrored position.
+ * @return The 64-bit key of the position.
+ */
+    KeyPair keys = boardKeys(state);
+    for (int i = 0; i < 2; ++i) {
+        addCardKey(keys, Zobrist.redCard, cardIndex(redMoveCards[i]));
+        addCardKey(keys, Zobrist.blueCard, cardIndex(blueMoveCards[i]));
+    }
+    return canonicalKey(keys, mirrored);
+}
+
+Move mirrorMove(const Move &move) {
+/**
+ * Reflects a move left to right, including the card it uses, so a move stored for the mirrored
+ * position can be played in the original one and the other way around.
+ */
+    Move mirroredMove = move;
+    mirroredMove.x1 = BOARD_SIZE - 1 - move.x1;
+    mirroredMove.x2 = BOARD_SIZE - 1 - move.x2;
+    int card = cardIndex(move.usedCard);
+    if (card >= 0 && CardMirror.of[card] >= 0) {
+        mirroredMove.usedCard = FullDeck[CardMirror.of[card]];
+    }
+    return mirroredMove;
+}
+
+#endif // HASHING_H
@@ -9,13 +9,32 @@
 #include "components.h"
 #include "display.h"
 #include "minimax.h"
+#include "pnsearch.h"
+#include "expectimax.h"
 
 // This is an Onitama board game algorithm which implements the MiniMax algorithm and Alpha Beta pruning
 using namespace std;
 
-int main() {
-    unsigned seed =  chrono::system_clock::now().time_since_epoch().count();
-     default_random_engine random_engine(seed);
+int main(int argc, char *argv[]) {
+    unsigned seed = random_device()();
+    long long maxNodes = 0; // 0 searches by time, otherwise every AI move searches exactly this many nodes
+
+    // --seed N deals and draws the same cards as an earlier game with that seed,
+    // --nodes N makes the AI reproducible by giving every search a node limit instead of a time limit,
+    // --nnue FILE makes the AI evaluate positions with the network in FILE,
+    // --cache FILE keeps deep search results in FILE from one game to the next
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (string(argv[i]) == "--seed") {
+            seed = stoul(argv[i + 1]);
+        } else if (string(argv[i]) == "--nodes") {
+            maxNodes = stoll(argv[i + 1]);
+        } else if (string(argv[i]) == "--nnue" && loadNetwork(argv[i + 1])) {
+            searchOptions.neuralEvaluation = true;
+        } else if (string(argv[i]) == "--cache") {
+            analysisCache.open(argv[i + 1], ANALYSIS_CACHE_MEGABYTES, ANALYSIS_FLUSH_SECONDS);
+        }
+    }
+    mt19937 random_engine(seed);
     // Initialize game state
     GameState state;
     state.winner = NONE;
@@ -37,12 +56,22 @@ int main() {
     MoveCard redMoveCards[2] = {Deck[randomIndices[0]], Deck[randomIndices[1]]};
     MoveCard blueMoveCards[2] = {Deck[randomIndices[2]], Deck[randomIndices[3]]};
 
-    // remove intitialized cards from the running game deck
+    // remove intitialized cards from the running game deck, highest index first so the others don't shift
+    sort(randomIndices.begin(), randomIndices.end());
     for (auto it = randomIndices.rbegin(); it != randomIndices.rend(); ++it) {
         Deck.erase(Deck.begin() + *it);
     }
 
-    int maxDepth = 5; // Adjust the search depth as needed
+    int maxDepth = 20; // Adjust the search depth as needed
+    int moveTimeMs = 1000; // The AI always answers within this time
+    int hintLines = 3; // Moves suggested when the player types "hint"
+    bool searchCardDraws = true; // Average over the cards that can be drawn instead of assuming fixed hands
+    int maxMoves = 200; // The game is a draw after this many moves
+
+    // Before every AI move the solver gets a small budget to look for a forced win
+    ProofNumberSolver solver(16);
+    ProofSearchLimits solverLimits = {200000, 250, 16};
+    string solverMessage;
 
     printBorderScreen("Onitama");
     printOnitamaPieces();
@@ -55,27 +84,51 @@ int main() {
         state.currentPlayer = RED;
     }
 
-    while (state.winner == NONE) {
+    int movesPlayed = 0;
+    while (state.winner == NONE && movesPlayed < maxMoves) {
         Move currentMove;
         string inputcurrentMove;
         string inputBlueUsedCard;
     
         system("clear");
 
-        int alpha =  numeric_limits<int>::min();
-        int beta =  numeric_limits<int>::max();
-
         printBorderScreen("Onitama");
         cout << redMoveCards[0].name << " " << redMoveCards[1].name <<  endl;
         printBoard(state.board);
         cout << blueMoveCards[0].name << " " << blueMoveCards[1].name <<  endl;
+        if (!solverMessage.empty()) {
+            cout << solverMessage << endl;
+        }
 
         generateLegalMoves(state, redMoveCards, blueMoveCards);
+        recordGamePosition(state, redMoveCards, blueMoveCards);
+        const vector<Move> &legalMoves = (state.currentPlayer == RED) ? state.redLegalMoves : state.blueLegalMoves;
 
-        if (state.currentPlayer == BLUE){ // Human
+        if (legalMoves.empty()) {
+            // Nothing to ask or search for, the turn passes
+            currentMove.x1 = -1;
+        }
+        else if (state.currentPlayer == BLUE){ // Human
 
-            cout << "What is your move? ex. (0,1) -> (1,1)\n";
+            cout << "What is your move? ex. (0,1) -> (1,1), or hint\n";
             getline(cin, inputcurrentMove);
+
+            // Show the best few moves with their scores and the lines the AI expects to follow
+            while (inputcurrentMove == "hint") {
+                SearchLimits limits = {maxDepth, chrono::steady_clock::now() + chrono::milliseconds(moveTimeMs), maxNodes};
+                MultiPvResult hint = multiPvSearch(state, hintLines, limits, redMoveCards, blueMoveCards);
+                cout << "Best moves at depth " << hint.depth << " (scores are from red's side):" << endl;
+                for (size_t i = 0; i < hint.lines.size(); ++i) {
+                    cout << i + 1 << ". " << formatMove(hint.lines[i].move) << "  score " << hint.lines[i].score << endl;
+                    cout << "  ";
+                    for (const auto &move : hint.lines[i].pv) {
+                        cout << " " << formatMove(move) << ";";
+                    }
+                    cout << endl;
+                }
+                cout << "What is your move? ex. (0,1) -> (1,1), or hint\n";
+                getline(cin, inputcurrentMove);
+            }
             currentMove = parseMoveInput(inputcurrentMove);
 
             while(isMoveValid(state, currentMove) == false){
@@ -94,51 +147,55 @@ int main() {
         }
         else if (state.currentPlayer == RED){ // AI
 
-            // Find the best move for the current player using MiniMax with alpha-beta pruning
-            int eval = miniMaxAlphaBeta(state, maxDepth, alpha, beta, true, currentMove, redMoveCards, blueMoveCards);
-
-        }
-
-        // Store the state of the target piece before applying the move
-        Piece targetPiece = state.board[currentMove.x2][currentMove.y2];
-        // Apply the best move found
-        applyMove(state, currentMove, redMoveCards, blueMoveCards);
-
-        // Check if the move currentMove results in a win
-        checkWinner(state, currentMove, targetPiece, redMoveCards, blueMoveCards);
-
-        // Remove value equlivalent to currentMove.usedCard from the Deck
-        Deck.erase( remove_if(Deck.begin(), Deck.end(), [&currentMove](const MoveCard &card) {
-            return card == currentMove.usedCard;
-
-        }), Deck.end());
+            // Play a proven forced win when the solver finds one, whatever cards get drawn
+            ProofSearchResult proof = solver.solve(state, redMoveCards, blueMoveCards, Deck, solverLimits);
+            if (proof.result == PROVEN_WIN && !proof.proofLine.empty() && proof.proofLine[0].x1 >= 0) {
+                currentMove = proof.proofLine[0];
+                solverMessage = "Red wins in at most " + to_string((proof.plies + 1) / 2) + " moves";
+            } else {
+                // Find the best move for the current player using MiniMax with alpha-beta pruning,
+                // searching deeper until the time is up and showing every finished depth
+                SearchLimits limits = {maxDepth, chrono::steady_clock::now() + chrono::milliseconds(moveTimeMs), maxNodes};
+                auto printProgress = [](const SearchResult &progress) {
+                    cout << "depth " << progress.depth << " score " << progress.score << " nodes " << progress.nodes << endl;
+                };
+                if (searchCardDraws) {
+                    currentMove = expectimaxSearch(state, limits, redMoveCards, blueMoveCards, Deck, nullptr, printProgress).bestMove;
+                } else {
+                    auto search = startSearch(state, redMoveCards, blueMoveCards, limits, printProgress);
+                    currentMove = search->wait().bestMove;
+                }
+            }
 
-        // if the deck is empty refill it
-        if (Deck.size() == 0){
-            Deck = {Tiger, Dragon, Frog, Rabbit, Crab, Elephant, Goose, Rooster, Monkey, Mantis, Horse, Ox, Crane, Boar, Eel, Cobra};
         }
 
-        // Swap out player cards 
-        vector<int> nextCardIndices;
-        generateUniqueRandomIndices(Deck.size(), nextCardIndices, random_engine);
-        nextCardIndices.resize(1);
-
-        int currentMoveIndex;
-        if (state.currentPlayer == RED){
-            // grab index of currentMove.usedCard in redMoveCards
-            currentMoveIndex = (redMoveCards[0] == currentMove.usedCard) ? 0 : 1;
-            redMoveCards[currentMoveIndex] = Deck[nextCardIndices[0]];
-        }
-            // grab index of currentMove.usedCard in blueMoveCards
-        else if (state.currentPlayer == BLUE){
-            currentMoveIndex = (blueMoveCards[0] == currentMove.usedCard) ? 0 : 1;
-            blueMoveCards[currentMoveIndex] = Deck[nextCardIndices[0]];
+        MoveCard *moveCards = (state.currentPlayer == RED) ? redMoveCards : blueMoveCards;
+        if (currentMove.x1 < 0) {
+            // Without a legal move the side to move passes and exchanges its first card
+            cout << ((state.currentPlayer == RED) ? "Red" : "Blue") << " has no legal move and passes" << endl;
+            replaceUsedCard(Deck, moveCards, moveCards[0], random_engine);
+        } else {
+            // Store the state of the target piece before applying the move
+            Piece targetPiece = state.board[currentMove.x2][currentMove.y2];
+            // Apply the best move found
+            applyMove(state, currentMove, redMoveCards, blueMoveCards);
+
+            // Check if the move currentMove results in a win
+            checkWinner(state, targetPiece, redMoveCards, blueMoveCards);
+
+            // Swap out player cards
+            replaceUsedCard(Deck, moveCards, currentMove.usedCard, random_engine);
         }
 
         // Update the current player
         state.currentPlayer = (state.currentPlayer == RED) ? BLUE : RED;
+        ++movesPlayed;
+    }
 
+    if (state.winner == NONE) {
+        cout << "Draw after " << movesPlayed << " moves" << endl;
     }
+    cout << "Seed " << seed << endl;
 
     return 0;
 }
@@ -12,35 +12,85 @@ using namespace std;
 #include <algorithm>
 #include <ctime>
 #include <string>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <memory>
+#include <functional>
+#include <cstdint>
 #include "components.h"
 #include "display.h"
+#include "hashing.h"
+#include "nnue.h"
+#include "analysiscache.h"
+#include "trace.h"
 
 
-void checkWinner(GameState &state, const Move &move, Piece &targetPiece, MoveCard *redMoveCards, MoveCard *blueMoveCards) {
+// Score of a won game before the distance to the win is subtracted
+const int WIN_SCORE = 10000;
+// Longest line the search will ever look down, scores beyond WIN_SCORE - MAX_PLY are won games
+const int MAX_PLY = 64;
+
+Player winnerOfMove(const GameState &state, const Move &move) {
+/**
+ * Determines whether playing the given move ends the game.
+ * A move wins if it captures the opponent's master (Way of the Stone) or if it carries the
+ * player's own master onto the opponent's temple (Way of the Stream). Red's temple is at (2,4)
+ * and Blue's temple is at (2,0). The board is inspected before the move is applied.
+
+ * @param state The game state before the move is applied.
+ * @param move The move to check.
+ * @return The player who wins by making the move, or NONE if the game goes on.
+ */
+    Piece movingPiece = state.board[move.x1][move.y1];
+    Piece targetPiece = state.board[move.x2][move.y2];
+
+    if (movingPiece == RED_STUDENT || movingPiece == RED_MASTER) {
+        if (targetPiece == BLUE_MASTER || (movingPiece == RED_MASTER && move.x2 == 2 && move.y2 == 0)) {
+            return RED;
+        }
+    } else if (movingPiece == BLUE_STUDENT || movingPiece == BLUE_MASTER) {
+        if (targetPiece == RED_MASTER || (movingPiece == BLUE_MASTER && move.x2 == 2 && move.y2 == 4)) {
+            return BLUE;
+        }
+    }
+
+    return NONE;
+}
+
+int winScore(Player winner, int ply) {
+/**
+ * Converts a won game into a search score from the red player's point of view.
+ * Wins that happen sooner score higher than wins further down the tree, so the search prefers
+ * the fastest win and, when losing, the slowest loss.
+
+ * @param winner The player who won the game.
+ * @param ply The number of moves from the root of the search to the winning position.
+ * @return WIN_SCORE - ply for a red win, or the negation for a blue win.
+ */
+    return (winner == RED) ? WIN_SCORE - ply : -(WIN_SCORE - ply);
+}
+
+void checkWinner(GameState &state, Piece &targetPiece, MoveCard *redMoveCards, MoveCard *blueMoveCards) {
 /**
- * Checks if the given move results in a win condition for the current player.
- * This function checks if the move results in a win condition, either by capturing the opponent's
- * master (Way of the Stone) or moving the player's own master to the opponent's temple (Way of the Stream).
- * If a win condition is met, the function updates the game state's winner attribute and prints the
- * winning message.
+ * Announces the win if the move just applied ended the game.
+ * applyMove has already recorded the winner in the game state. This function tells from the captured
+ * piece whether the game was won by capturing the opponent's master (Way of the Stone) or by moving
+ * the player's own master to the opponent's temple (Way of the Stream), and prints the winning message.
     
  * @param[in,out] state The current game state.
- * @param[in] move The move to check for a win condition.
  * @param[in] targetPiece The piece at the destination cell of the move (before the move is applied).
  */ 
     string borderScreenString;
 
-    // Is there a winner?
-    if (state.currentPlayer == RED && targetPiece == BLUE_MASTER) {
-        state.winner = RED;
+    // Is there a winner? applyMove has already recorded it, the captured piece tells us how it was won
+    if (state.winner == RED && targetPiece == BLUE_MASTER) {
         system("clear");
         borderScreenString = "Red player wins by Way of the Stone!";
-    } else if (state.currentPlayer == BLUE && targetPiece == RED_MASTER) {
-        state.winner = BLUE;
+    } else if (state.winner == BLUE && targetPiece == RED_MASTER) {
         system("clear");
         borderScreenString = "Blue player wins by Way of the Stone!";
-    } else if (move.x2 == 2 && (move.y2 == 4 && targetPiece == BLUE_MASTER || move.y2 == 0 && targetPiece == RED_MASTER)) {
-        state.winner = state.currentPlayer;
+    } else if (state.winner != NONE) {
         system("clear");
         borderScreenString = (state.winner == RED ? "Red" : "Blue") + string(" player wins by Way of the Stream!");
     }
@@ -104,6 +154,7 @@ void generateLegalMoves(GameState &state, MoveCard *redMoveCards, MoveCard *blue
  * @param[in] redMoveCards Pointer to an array of move cards for the red player.
  * @param[in] blueMoveCards Pointer to an array of move cards for the blue player.
  */
+    TRACE_SPAN("movegen");
 
     state.redLegalMoves.clear();
     state.blueLegalMoves.clear();
@@ -139,37 +190,87 @@ void generateLegalMoves(GameState &state, MoveCard *redMoveCards, MoveCard *blue
 }
 
 
+// For every card, side and target square, the squares from which a piece of that side could capture on
+// the target with the card. Bit x * BOARD_SIZE + y stands for square (x,y).
+struct AttackTable {
+    uint32_t attackers[DECK_SIZE][2][BOARD_SIZE * BOARD_SIZE];
+};
+
+AttackTable buildAttackTable() {
+    AttackTable table = {};
+    for (int card = 0; card < DECK_SIZE; ++card) {
+        const MoveCard &moveCard = FullDeck[card];
+        for (int x = 0; x < BOARD_SIZE; ++x) {
+            for (int y = 0; y < BOARD_SIZE; ++y) {
+                for (int j = 0; j < moveCard.numMoves; ++j) {
+                    // red moves are negated, so a red attacker sits one card offset ahead of the target
+                    // and a blue attacker one offset behind it
+                    int redX = x + moveCard.dx[j];
+                    int redY = y + moveCard.dy[j];
+                    if (redX >= 0 && redX < BOARD_SIZE && redY >= 0 && redY < BOARD_SIZE) {
+                        table.attackers[card][RED][x * BOARD_SIZE + y] |= 1u << (redX * BOARD_SIZE + redY);
+                    }
+                    int blueX = x - moveCard.dx[j];
+                    int blueY = y - moveCard.dy[j];
+                    if (blueX >= 0 && blueX < BOARD_SIZE && blueY >= 0 && blueY < BOARD_SIZE) {
+                        table.attackers[card][BLUE][x * BOARD_SIZE + y] |= 1u << (blueX * BOARD_SIZE + blueY);
+                    }
+                }
+            }
+        }
+    }
+    return table;
+}
+
+const AttackTable attackTable = buildAttackTable();
+
 int evaluate(const GameState &state, MoveCard *redMoveCards, MoveCard *blueMoveCards) {
+/**
+ * Evaluates the game state from the red player's point of view.
+ * The score only depends on the board and the cards in hand: material, whether each piece is out of
+ * reach of the opponent's cards on the next turn, and how close each master is to the opponent's temple.
+ * A positive score favours red and a negative score favours blue.
+ * Whether a piece is safe from a card is a single lookup in attackTable against the opponent's pieces.
+
+ * @param state The current GameState object representing the board and game state.
+ * @param redMoveCards A pointer to an array of red player's MoveCards.
+ * @param blueMoveCards A pointer to an array of blue player's MoveCards.
+ * @return An integer representing the advantage of the red player over the blue player.
+ */
+    TRACE_SPAN("evaluate");
     int score = 0;
-    const int CAPTURE_BLUE_POINTS = 2;
-    const int CAPTURE_BLUE_MASTER_POINTS = 20;
-    const int CAPTURE_RED_POINTS = -2;
-    const int CAPTURE_RED_MASTER_POINTS = -20;
-    const int PROTECT_POINTS = 1;
     const int RED_MASTER_CLOSER_TO_TEMPLE_POINTS = 1;
     const int BLUE_MASTER_CLOSER_TO_TEMPLE_POINTS = -1;
 
+    uint32_t redPieces = 0;
+    uint32_t bluePieces = 0;
+    for (int x = 0; x < BOARD_SIZE; ++x) {
+        for (int y = 0; y < BOARD_SIZE; ++y) {
+            Piece piece = state.board[x][y];
+            if (piece == RED_STUDENT || piece == RED_MASTER) {
+                redPieces |= 1u << (x * BOARD_SIZE + y);
+            } else if (piece == BLUE_STUDENT || piece == BLUE_MASTER) {
+                bluePieces |= 1u << (x * BOARD_SIZE + y);
+            }
+        }
+    }
+
+    const uint32_t *redAttackers[2] = {attackTable.attackers[cardIndex(redMoveCards[0])][RED],
+                                       attackTable.attackers[cardIndex(redMoveCards[1])][RED]};
+    const uint32_t *blueAttackers[2] = {attackTable.attackers[cardIndex(blueMoveCards[0])][BLUE],
+                                        attackTable.attackers[cardIndex(blueMoveCards[1])][BLUE]};
+
     for (int x = 0; x < BOARD_SIZE; ++x) {
         for (int y = 0; y < BOARD_SIZE; ++y) {
             Piece piece = state.board[x][y];
+            int square = x * BOARD_SIZE + y;
             if (piece == RED_STUDENT || piece == RED_MASTER) {
-                // More points if red piece hasn't been captured
                 score += (piece == RED_MASTER) ? 10 : 1;
 
-                // Check if red piece can capture a blue piece or protect another red piece
-                for (const Move &move : state.redLegalMoves) {
-                    if (move.x1 == x && move.y1 == y) {
-                        int newX = move.x2;
-                        int newY = move.y2;
-
-                        Piece target = state.board[newX][newY];
-                        if (target == BLUE_STUDENT) {
-                            score += CAPTURE_BLUE_POINTS;
-                        } else if (target == BLUE_MASTER) {
-                            score += CAPTURE_BLUE_MASTER_POINTS;
-                        } else if (target == RED_STUDENT || target == RED_MASTER) {
-                            score += PROTECT_POINTS;
-                        }
+                // Check if the piece is not in a position to be captured on the next turn
+                for (size_t i = 0; i < 2; ++i) {
+                    if ((blueAttackers[i][square] & bluePieces) == 0) {
+                        score += (piece == RED_MASTER) ? 10 : 2;
                     }
                 }
 
@@ -178,21 +279,12 @@ int evaluate(const GameState &state, MoveCard *redMoveCards, MoveCard *blueMoveC
                     score += RED_MASTER_CLOSER_TO_TEMPLE_POINTS * (4 - abs(x - 2) - y);
                 }
             } else if (piece == BLUE_STUDENT || piece == BLUE_MASTER) {
-                // Less points if blue piece hasn't been captured
                 score -= (piece == BLUE_MASTER) ? 10 : 1;
 
-                // Check if blue piece can capture a red piece
-                for (const Move &move : state.blueLegalMoves) {
-                    if (move.x1 == x && move.y1 == y) {
-                        int newX = move.x2;
-                        int newY = move.y2;
-
-                        Piece target = state.board[newX][newY];
-                        if (target == RED_STUDENT) {
-                            score += CAPTURE_RED_POINTS;
-                        } else if (target == RED_MASTER) {
-                            score += CAPTURE_RED_MASTER_POINTS;
-                        }
+                // Check if the piece is not in a position to be captured on the next turn
+                for (size_t i = 0; i < 2; ++i) {
+                    if ((redAttackers[i][square] & redPieces) == 0) {
+                        score -= (piece == BLUE_MASTER) ? 10 : 2;
                     }
                 }
 
@@ -213,25 +305,962 @@ void applyMove(GameState &state, const Move &move, MoveCard *redMoveCards, MoveC
  * The applyMove function takes a GameState reference and a Move reference, as well as pointers to
  * the red and blue players' move cards. It modifies the game state by moving the piece from its
  * original position to the destination position specified in the Move. It also updates the players'
- * positions on the board accordingly.
+ * positions on the board accordingly, and records the winner if the move captures a master or
+ * brings a master onto the opponent's temple.
     
  * @param state A reference to the current game state.
  * @param move A reference to the Move to be applied.
  * @param redMoveCards A pointer to the red player's move cards.
  * @param blueMoveCards A pointer to the blue player's move cards.
  */
-   
+    Player winner = winnerOfMove(state, move);
+
     state.board[move.x2][move.y2] = state.board[move.x1][move.y1];
     state.board[move.x1][move.y1] = EMPTY;
 
+    if (winner != NONE) {
+        state.winner = winner;
+    }
+
+}
+
+// Switches for the selective parts of the search, so their effect can be measured separately
+struct SearchOptions {
+    bool nullMovePruning;
+    bool lateMoveReductions;
+    bool transpositionTable;
+    bool neuralEvaluation;   // evaluate with the loaded network instead of evaluate()
+    bool quiescenceSearch;   // play out the captures at the horizon before evaluating
+};
+
+SearchOptions searchOptions = {true, true, true, false, true};
+
+// Counters filled in by the search, reset them before a search to measure a single move.
+// Every thread keeps its own counters so several searches can run side by side.
+struct SearchStats {
+    long long nodes;
+};
+
+thread_local SearchStats searchStats = {0};
+
+// How a running search is told to stop. The stop flag and the deadline are only looked at every
+// STOP_CHECK_INTERVAL nodes, which keeps the check cheap and the reaction time well under a millisecond.
+// The node limit is exact, so a node-limited search stops at the same node every time.
+struct SearchControl {
+    const atomic<bool> *stopFlag;
+    bool hasDeadline;
+    chrono::steady_clock::time_point deadline;
+    bool aborted;
+    long long maxNodes;   // 0 for no node limit
+};
+
+thread_local SearchControl searchControl = {nullptr, false, {}, false, 0};
+
+const long long STOP_CHECK_INTERVAL = 64;
+
+bool searchInterrupted() {
+/**
+ * Tells the search whether it has to unwind. Once a stop was seen every following call returns
+ * true, so the whole tree unwinds without looking at the clock again.
+ */
+    if (searchControl.aborted) {
+        return true;
+    }
+    if (searchControl.maxNodes > 0 && searchStats.nodes > searchControl.maxNodes) {
+        searchControl.aborted = true;
+        return true;
+    }
+    if (searchStats.nodes % STOP_CHECK_INTERVAL != 0) {
+        return false;
+    }
+    if ((searchControl.stopFlag && searchControl.stopFlag->load(memory_order_relaxed)) ||
+        (searchControl.hasDeadline && chrono::steady_clock::now() >= searchControl.deadline)) {
+        searchControl.aborted = true;
+    }
+    return searchControl.aborted;
+}
+
+const int NULL_MOVE_REDUCTION = 2;
+const int NULL_MOVE_MIN_DEPTH = 3;
+const int ENDGAME_PIECES = 2;
+const int LMR_MIN_DEPTH = 3;
+const int LMR_FULL_DEPTH_MOVES = 3;
+// Captures that lose material are not searched at this depth and below
+const int SEE_PRUNE_DEPTH = 2;
+
+enum BoundType { EXACT_BOUND, LOWER_BOUND, UPPER_BOUND };
+
+// One slot of the transposition table. Positions are stored under their canonical key, so the move
+// is kept as it is played in the canonical orientation and reflected back when read for the mirror.
+struct TranspositionEntry {
+    uint64_t key;
+    int score;
+    int8_t depth;
+    int8_t bound;
+    int8_t x1, y1, x2, y2;
+    int8_t card;
+};
+
+const size_t TRANSPOSITION_TABLE_MEGABYTES = 16;
+
+// Every search thread has its own table, allocated on first use
+thread_local vector<TranspositionEntry> transpositionTable;
+
+void resizeTranspositionTable(size_t megabytes) {
+/**
+ * Allocates the calling thread's transposition table with the largest power-of-two number of
+ * entries that fits in the given size, and clears it.
+ */
+    size_t entries = 1;
+    while (entries * 2 * sizeof(TranspositionEntry) <= megabytes * 1024 * 1024) {
+        entries *= 2;
+    }
+    transpositionTable.assign(entries, TranspositionEntry());
+}
+
+void clearTranspositionTable() {
+    fill(transpositionTable.begin(), transpositionTable.end(), TranspositionEntry());
+}
+
+// Won-game scores are stored relative to the node instead of the root, so an entry can be reused
+// at any ply
+int scoreToTransposition(int score, int ply) {
+    if (score >= WIN_SCORE - MAX_PLY) {
+        return score + ply;
+    }
+    if (score <= -(WIN_SCORE - MAX_PLY)) {
+        return score - ply;
+    }
+    return score;
+}
+
+int scoreFromTransposition(int score, int ply) {
+    if (score >= WIN_SCORE - MAX_PLY) {
+        return score - ply;
+    }
+    if (score <= -(WIN_SCORE - MAX_PLY)) {
+        return score + ply;
+    }
+    return score;
+}
+
+const TranspositionEntry *probeTranspositionTable(uint64_t key) {
+    TRACE_SPAN("hash probe");
+    if (transpositionTable.empty()) {
+        resizeTranspositionTable(TRANSPOSITION_TABLE_MEGABYTES);
+    }
+    const TranspositionEntry &entry = transpositionTable[key & (transpositionTable.size() - 1)];
+    return (entry.key == key && entry.depth > 0) ? &entry : nullptr;
+}
+
+void storeTransposition(uint64_t key, int depth, int score, BoundType bound, const Move &bestMove, bool mirrored, int ply) {
+/**
+ * Stores a search result, keeping the deeper result when the slot already holds this position.
+
+ * @param key The canonical key of the position.
+ * @param depth The depth the position was searched to.
+ * @param score The score found, from the red player's point of view.
+ * @param bound Whether the score is exact or only a lower or upper bound.
+ * @param bestMove The best move found, as played in the position.
+ * @param mirrored Whether the canonical key belongs to the mirrored position.
+ * @param ply The number of moves from the root of the search to the position.
+ */
+    TranspositionEntry &entry = transpositionTable[key & (transpositionTable.size() - 1)];
+    if (entry.key == key && entry.depth > depth) {
+        return;
+    }
+
+    Move storedMove = mirrored ? mirrorMove(bestMove) : bestMove;
+    entry.key = key;
+    entry.score = scoreToTransposition(score, ply);
+    entry.depth = depth;
+    entry.bound = bound;
+    entry.x1 = storedMove.x1;
+    entry.y1 = storedMove.y1;
+    entry.x2 = storedMove.x2;
+    entry.y2 = storedMove.y2;
+    entry.card = cardIndex(storedMove.usedCard);
+}
+
+bool probeAnalysisCache(uint64_t key, int depth, TranspositionEntry &entry) {
+/**
+ * Looks for a deep result in the analysis cache when the transposition table has none as deep.
+ * Cached scores come from evaluate(), so the cache is left alone while the network evaluates. A
+ * node-limited search doesn't look either, its result must not depend on what other runs left there.
+ */
+    AnalysisEntry found;
+    if (depth < ANALYSIS_CACHE_MIN_DEPTH || !analysisCache.isOpen() || searchOptions.neuralEvaluation || searchControl.maxNodes > 0 ||
+        !analysisCache.probe(key, found)) {
+        return false;
+    }
+    entry = {found.key, found.score, found.depth, found.bound, found.x1, found.y1, found.x2, found.y2, found.card};
+    return true;
+}
+
+void recordAnalysis(uint64_t key, int depth) {
+/**
+ * Copies a deep result that was just stored in the transposition table to the analysis cache.
+ */
+    if (depth < ANALYSIS_CACHE_MIN_DEPTH || !analysisCache.isOpen() || searchOptions.neuralEvaluation) {
+        return;
+    }
+    const TranspositionEntry &entry = transpositionTable[key & (transpositionTable.size() - 1)];
+    if (entry.key == key && entry.depth == depth) {
+        analysisCache.record({entry.key, entry.score, entry.depth, entry.bound, entry.x1, entry.y1, entry.x2, entry.y2, entry.card, 0});
+    }
+}
+
+// Triangular principal variation table: principalVariation[ply] is the best line found from the
+// node at that ply, built from the line of its best child as the search returns up the tree.
+// A pass is stored as a move with x1 = -1.
+thread_local vector<Move> principalVariation[MAX_PLY + 1];
+
+void updatePrincipalVariation(int ply, const Move &move) {
+/**
+ * Makes move followed by the best line of the child node the principal variation at ply.
+ */
+    if (ply >= MAX_PLY) {
+        return;
+    }
+    vector<Move> &line = principalVariation[ply];
+    line.clear();
+    line.push_back(move);
+    line.insert(line.end(), principalVariation[ply + 1].begin(), principalVariation[ply + 1].end());
+}
+
+// Network accumulators of the positions on the current line, accumulatorStack[ply] belongs to the
+// node at that ply. A child's accumulator is derived from its parent's before the child is searched,
+// and going back to the parent needs no undo since its entry is left as it was.
+thread_local NnueAccumulator accumulatorStack[MAX_PLY + 1];
+
+void pushMoveAccumulator(int ply, const GameState &state, const Move &move) {
+    if (searchOptions.neuralEvaluation && ply < MAX_PLY) {
+        updateAccumulator(accumulatorStack[ply], accumulatorStack[ply + 1], state, move);
+    }
+}
+
+void pushPassAccumulator(int ply, Player toMove) {
+    if (searchOptions.neuralEvaluation && ply < MAX_PLY) {
+        passAccumulator(accumulatorStack[ply], accumulatorStack[ply + 1], toMove);
+    }
+}
+
+int networkScore(const NnueAccumulator &accumulator) {
+/**
+ * Network score kept below the won-game range, so it is never taken for a forced win.
+ */
+    TRACE_SPAN("evaluate network");
+    const int LIMIT = WIN_SCORE - MAX_PLY - 1;
+    return max(-LIMIT, min(LIMIT, evaluateNetwork(accumulator)));
 }
 
-int miniMaxAlphaBeta(GameState &state, int depth, int alpha, int beta, bool maximizingPlayer, Move &bestMove, MoveCard *redMoveCards, MoveCard *blueMoveCards) {
+int staticEvaluation(const GameState &state, MoveCard *redMoveCards, MoveCard *blueMoveCards, int ply) {
+/**
+ * Scores a leaf of the search: with the network when searchOptions.neuralEvaluation is set, using
+ * the accumulator kept up to date along the line, and with evaluate() otherwise.
+ */
+    if (searchOptions.neuralEvaluation && ply <= MAX_PLY) {
+        return networkScore(accumulatorStack[ply]);
+    }
+    return evaluate(state, redMoveCards, blueMoveCards);
+}
+
+bool isCapture(const GameState &state, const Move &move) {
+    return state.board[move.x2][move.y2] != EMPTY;
+}
+
+int countPieces(const GameState &state, Player player) {
+    int count = 0;
+    for (int x = 0; x < BOARD_SIZE; ++x) {
+        for (int y = 0; y < BOARD_SIZE; ++y) {
+            Piece piece = state.board[x][y];
+            if ((player == RED && (piece == RED_STUDENT || piece == RED_MASTER)) ||
+                (player == BLUE && (piece == BLUE_STUDENT || piece == BLUE_MASTER))) {
+                ++count;
+            }
+        }
+    }
+    return count;
+}
+
+// Piece values for the static exchange evaluation, losing the master loses the game
+const int SEE_STUDENT_VALUE = 1;
+const int SEE_MASTER_VALUE = 100;
+
+// The pieces of both sides and the squares their cards capture from, all the exchange evaluation needs
+struct ExchangeInfo {
+    uint32_t pieces[2];
+    uint32_t masters[2];
+    const uint32_t *attackers[2][2];
+};
+
+ExchangeInfo exchangeInfo(const GameState &state, MoveCard *redMoveCards, MoveCard *blueMoveCards) {
+    ExchangeInfo info = {};
+    for (int x = 0; x < BOARD_SIZE; ++x) {
+        for (int y = 0; y < BOARD_SIZE; ++y) {
+            Piece piece = state.board[x][y];
+            uint32_t bit = 1u << (x * BOARD_SIZE + y);
+            if (piece == RED_STUDENT || piece == RED_MASTER) {
+                info.pieces[RED] |= bit;
+            } else if (piece == BLUE_STUDENT || piece == BLUE_MASTER) {
+                info.pieces[BLUE] |= bit;
+            }
+            if (piece == RED_MASTER) {
+                info.masters[RED] |= bit;
+            } else if (piece == BLUE_MASTER) {
+                info.masters[BLUE] |= bit;
+            }
+        }
+    }
+    for (int i = 0; i < 2; ++i) {
+        info.attackers[RED][i] = attackTable.attackers[cardIndex(redMoveCards[i])][RED];
+        info.attackers[BLUE][i] = attackTable.attackers[cardIndex(blueMoveCards[i])][BLUE];
+    }
+    return info;
+}
+
+int squareOf(uint32_t bit) {
+    return __builtin_ctz(bit);
+}
+
+bool threatensWin(const ExchangeInfo &info, Player player) {
+/**
+ * Checks with a few mask operations whether a player could win with its next move: one of its pieces
+ * reaches the opponent's master, or its master reaches the opponent's temple and no student of its
+ * own stands there.
+ */
+    Player opponent = (player == RED) ? BLUE : RED;
+    const uint32_t *const *attackers = info.attackers[player];
+    if (info.masters[opponent]) {
+        int masterSquare = squareOf(info.masters[opponent]);
+        if ((attackers[0][masterSquare] | attackers[1][masterSquare]) & info.pieces[player]) {
+            return true;
+        }
+    }
+    int temple = 2 * BOARD_SIZE + ((player == RED) ? 0 : 4);
+    return ((attackers[0][temple] | attackers[1][temple]) & info.masters[player]) && !(info.pieces[player] & (1u << temple));
+}
+
+int staticExchange(const ExchangeInfo &info, const GameState &state, const Move &move) {
+/**
+ * Static exchange evaluation: the material the side making a capture ends up with once both sides
+ * have recaptured on the target square for as long as it pays, each side always taking with a student
+ * before its master. Cards move pieces by jumping, so nothing blocks or uncovers an attacker and the
+ * attackers of the square are known up front. Taking the master ends the exchange, and the game.
+
+ * @param info The pieces and cards of both sides, from exchangeInfo.
+ * @param state The game state before the move.
+ * @param move The capture.
+ * @return The material won, in SEE_STUDENT_VALUE and SEE_MASTER_VALUE units, 0 for a quiet move.
+ */
+    Piece captured = state.board[move.x2][move.y2];
+    if (captured == EMPTY) {
+        return 0;
+    }
+    int gain[BOARD_SIZE * BOARD_SIZE + 1];
+    gain[0] = (captured == RED_MASTER || captured == BLUE_MASTER) ? SEE_MASTER_VALUE : SEE_STUDENT_VALUE;
+    if (gain[0] == SEE_MASTER_VALUE) {
+        return gain[0];
+    }
+
+    int target = move.x2 * BOARD_SIZE + move.y2;
+    uint32_t from = 1u << (move.x1 * BOARD_SIZE + move.y1);
+    int side = (info.pieces[RED] & from) ? RED : BLUE;
+    uint32_t attackers[2];
+    for (int player = RED; player <= BLUE; ++player) {
+        attackers[player] = (info.attackers[player][0][target] | info.attackers[player][1][target]) & info.pieces[player];
+    }
+    attackers[side] &= ~from;
+    bool masterOnSquare = (info.masters[side] & from) != 0;
+
+    int depth = 0;
+    int toMove = 1 - side;
+    while (attackers[toMove]) {
+        ++depth;
+        gain[depth] = (masterOnSquare ? SEE_MASTER_VALUE : SEE_STUDENT_VALUE) - gain[depth - 1];
+        if (masterOnSquare) {
+            break;
+        }
+        uint32_t students = attackers[toMove] & ~info.masters[toMove];
+        uint32_t attacker = students ? (students & (0u - students)) : attackers[toMove];
+        attackers[toMove] &= ~attacker;
+        masterOnSquare = students == 0;
+        toMove = 1 - toMove;
+    }
+
+    // Either side may stop recapturing when going on would cost it
+    while (depth > 0) {
+        gain[depth - 1] = -max(-gain[depth - 1], gain[depth]);
+        --depth;
+    }
+    return gain[0];
+}
+
+bool canWinNextMove(const GameState &state, Player player, MoveCard *redMoveCards, MoveCard *blueMoveCards) {
+/**
+ * Checks whether the given player has a move that wins the game on the spot.
+ * This is true when one of the player's pieces can capture the opponent's master with one of the
+ * player's cards, or when the player's master can step onto the opponent's temple.
+
+ * @param state The current game state.
+ * @param player The player whose threats are checked, independent of whose turn it is.
+ * @param redMoveCards A pointer to an array of MoveCard objects for the red player.
+ * @param blueMoveCards A pointer to an array of MoveCard objects for the blue player.
+ * @return true if the player could win with their next move.
+ */
+    return threatensWin(exchangeInfo(state, redMoveCards, blueMoveCards), player);
+}
+
+// Score of a drawn game, neither side is better off
+const int DRAW_SCORE = 0;
+
+// One position of the game or of the line being searched. Positions only repeat while the number of
+// pieces stays the same, so a search for a repetition stops at the first entry with a different count.
+struct HistoryEntry {
+    uint64_t key;
+    int pieces;
+};
+
+// The positions of the current game followed by those on the line being searched, oldest first.
+// The game loop adds a position before every move; the search adds each node while it is searched.
+thread_local vector<HistoryEntry> positionHistory;
+
+// Repetition draws this thread's searches have scored so far. A node whose subtree scored one has a
+// result that only holds for this game's history, which must not be stored for other games to reuse.
+thread_local long long repetitionDraws = 0;
+
+void recordGamePosition(const GameState &state, MoveCard *redMoveCards, MoveCard *blueMoveCards) {
+/**
+ * Adds a position of the game to positionHistory, so the search can recognise a return to it.
+
+ * @param state The position, with currentPlayer set to the side to move.
+ * @param redMoveCards A pointer to an array of the red player's two MoveCards.
+ * @param blueMoveCards A pointer to an array of the blue player's two MoveCards.
+ */
+    positionHistory.push_back({positionKey(state, redMoveCards, blueMoveCards), countPieces(state, RED) + countPieces(state, BLUE)});
+}
+
+bool isRepetition(uint64_t key, int pieces) {
+/**
+ * Tells whether the position already occurred. Only the entries back to the last capture are
+ * looked at, nothing before it can have the same pieces on the board.
+ */
+    for (auto entry = positionHistory.rbegin(); entry != positionHistory.rend() && entry->pieces == pieces; ++entry) {
+        if (entry->key == key) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Keeps a node in positionHistory while it is being searched
+struct HistoryGuard {
+    HistoryGuard(uint64_t key, int pieces) {
+        positionHistory.push_back({key, pieces});
+    }
+    ~HistoryGuard() {
+        positionHistory.pop_back();
+    }
+};
+
+bool nullMoveAllowed(const GameState &state, int depth, int alpha, int beta, bool maximizingPlayer, MoveCard *redMoveCards, MoveCard *blueMoveCards) {
+/**
+ * Decides whether a null move (passing the turn) may be tried at this node.
+ * Passing is only a sound way to prove a cutoff when the side to move is not in danger, so it is
+ * skipped when the opponent threatens to win on the next move, in endgames where a side is down to
+ * its master and one student, near won-game scores, and at shallow depths.
+ */
+    if (!searchOptions.nullMovePruning || depth < NULL_MOVE_MIN_DEPTH) {
+        return false;
+    }
+
+    // The null window is built around the bound, which has to be an ordinary evaluation
+    int bound = maximizingPlayer ? beta : alpha;
+    if (bound <= -(WIN_SCORE - MAX_PLY) || bound >= WIN_SCORE - MAX_PLY) {
+        return false;
+    }
+
+    if (countPieces(state, RED) <= ENDGAME_PIECES || countPieces(state, BLUE) <= ENDGAME_PIECES) {
+        return false;
+    }
+
+    Player opponent = maximizingPlayer ? BLUE : RED;
+    return !canWinNextMove(state, opponent, redMoveCards, blueMoveCards);
+}
+
+bool sameMove(const Move &a, const Move &b) {
+    return a.x1 == b.x1 && a.y1 == b.y1 && a.x2 == b.x2 && a.y2 == b.y2 && a.usedCard == b.usedCard;
+}
+
+// Captures and moves that win on the spot, everything else is a quiet move
+bool isTactical(const GameState &state, const Move &move) {
+    return isCapture(state, move) || winnerOfMove(state, move) != NONE;
+}
+
+bool isMoveInHand(const GameState &state, const Move &move, MoveCard *moveCards) {
+/**
+ * Checks that a move taken from elsewhere, like the transposition table or a killer slot, can be
+ * played here: the side to move has a piece on the start square, holds the card, the card allows the
+ * step and the target square isn't taken by one of its own pieces.
+ */
+    if (move.x1 < 0 || move.x1 >= BOARD_SIZE || move.y1 < 0 || move.y1 >= BOARD_SIZE ||
+        move.x2 < 0 || move.x2 >= BOARD_SIZE || move.y2 < 0 || move.y2 >= BOARD_SIZE) {
+        return false;
+    }
+    bool isRedPlayer = state.currentPlayer == RED;
+    Piece piece = state.board[move.x1][move.y1];
+    Piece target = state.board[move.x2][move.y2];
+    bool ownPiece = isRedPlayer ? (piece == RED_STUDENT || piece == RED_MASTER) : (piece == BLUE_STUDENT || piece == BLUE_MASTER);
+    bool ownTarget = isRedPlayer ? (target == RED_STUDENT || target == RED_MASTER) : (target == BLUE_STUDENT || target == BLUE_MASTER);
+    if (!ownPiece || ownTarget) {
+        return false;
+    }
+    for (int cardIdx = 0; cardIdx < 2; ++cardIdx) {
+        const MoveCard &card = moveCards[cardIdx];
+        if (!(card == move.usedCard)) {
+            continue;
+        }
+        for (int moveIdx = 0; moveIdx < card.numMoves; ++moveIdx) {
+            int dx = isRedPlayer ? -card.dx[moveIdx] : card.dx[moveIdx];
+            int dy = isRedPlayer ? -card.dy[moveIdx] : card.dy[moveIdx];
+            if (move.x1 + dx == move.x2 && move.y1 + dy == move.y2) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Quiet moves that caused a cutoff, two per ply, tried before the other quiet moves at the same ply
+thread_local Move killerMoves[MAX_PLY + 1][2];
+
+void clearKillerMoves() {
+    for (auto &killers : killerMoves) {
+        killers[0] = Move();
+        killers[1] = Move();
+    }
+}
+
+void storeKillerMove(int ply, const Move &move) {
+    if (ply > MAX_PLY || sameMove(killerMoves[ply][0], move)) {
+        return;
+    }
+    killerMoves[ply][1] = killerMoves[ply][0];
+    killerMoves[ply][0] = move;
+}
+
+// Stages of the move picker, in the order their moves come out
+enum PickerStage { HASH_STAGE, WINNING_STAGE, CAPTURE_STAGE, KILLER_STAGE, QUIET_STAGE, BAD_CAPTURE_STAGE, DONE_STAGE };
+
+// Hands out the moves of a node one at a time, best candidates first, and only generates a group of
+// moves once the ones before it failed to cut the node off: the hash move, moves that win on the
+// spot, captures that don't lose material by static exchange evaluation, best first, the killer
+// moves of the ply, the remaining quiet moves, and last the captures that lose material. Most nodes
+// cut off on one of the first moves and never generate the quiet moves at all. A picker made for
+// the quiescence search stops after the captures that don't lose material.
+class MovePicker {
+public:
+    MovePicker(const GameState &state, MoveCard *redMoveCards, MoveCard *blueMoveCards, const Move *hashMove, int ply,
+               bool capturesOnly = false)
+        : state(state), moveCards(state.currentPlayer == RED ? redMoveCards : blueMoveCards), capturesOnly(capturesOnly), currentStage(HASH_STAGE), lastStage(HASH_STAGE),
+          index(0), winningMoves(0), goodCaptures(0), tacticalGenerated(false), hasHashMove(false), killerCount(0),
+          defending(false), defenceIndex(0) {
+        info = exchangeInfo(state, redMoveCards, blueMoveCards);
+        if (hashMove && isMoveInHand(state, *hashMove, moveCards)) {
+            this->hashMove = *hashMove;
+            this->hashMove.usedPiece = state.board[hashMove->x1][hashMove->y1];
+            hasHashMove = true;
+        }
+        for (int i = 0; i < 2 && ply <= MAX_PLY && !capturesOnly; ++i) {
+            const Move &killer = killerMoves[ply][i];
+            if (isMoveInHand(state, killer, moveCards) && !isTactical(state, killer) &&
+                !(hasHashMove && sameMove(killer, this->hashMove))) {
+                killers[killerCount] = killer;
+                killers[killerCount].usedPiece = state.board[killer.x1][killer.y1];
+                ++killerCount;
+            }
+        }
+    }
+
+    // Whether a player could win with its next move, from the masks alone
+    bool canWin(Player player) const {
+        return threatensWin(info, player);
+    }
+
+    bool findWinningMove(Move &move) {
+    /**
+     * Looks for a move that wins the game right away. The masks tell first whether there is one, only
+     * then are the captures and master moves onto the temple generated, and kept for the capture stages.
+     */
+        if (!canWin(state.currentPlayer)) {
+            return false;
+        }
+        generateTactical();
+        if (winningMoves > 0) {
+            move = tactical[0];
+            return true;
+        }
+        return false;
+    }
+
+    bool hasMoves() {
+    /**
+     * Tells whether the side to move has any legal move, stopping at the first one found.
+     */
+        if (hasHashMove || killerCount > 0 || (tacticalGenerated && !tactical.empty())) {
+            return true;
+        }
+        auto anyMove = [](const Move &) { return true; };
+        return forEachMove(true, anyMove) || forEachMove(false, anyMove);
+    }
+
+    size_t defendAgainstWin() {
+    /**
+     * Restricts the picker to the moves after which the opponent can no longer win on its next move,
+     * every other move loses on the spot. The moves keep their stage order. A capture-only picker
+     * also hands out quiet defences from then on. Call it before the first call to next.
+
+     * @return The number of moves that stop the threat, 0 if the game is lost.
+     */
+        capturesOnly = false;
+        Move move;
+        while (nextStaged(move)) {
+            if (stopsWin(move)) {
+                defences.push_back({move, lastStage});
+            }
+        }
+        defending = true;
+        return defences.size();
+    }
+
+    bool next(Move &move) {
+    /**
+     * Gives the next move to search.
+
+     * @param[out] move The move.
+     * @return false once every legal move has been handed out.
+     */
+        if (defending) {
+            if (defenceIndex == defences.size()) {
+                return false;
+            }
+            move = defences[defenceIndex].first;
+            lastStage = defences[defenceIndex].second;
+            ++defenceIndex;
+            return true;
+        }
+        return nextStaged(move);
+    }
+
+    // The stage of the move last returned by next
+    PickerStage stage() const {
+        return lastStage;
+    }
+
+private:
+    const GameState &state;
+    MoveCard *moveCards;
+    bool capturesOnly;
+    PickerStage currentStage;
+    PickerStage lastStage;
+    size_t index;
+    size_t winningMoves;
+    size_t goodCaptures;
+    bool tacticalGenerated;
+    vector<Move> tactical;
+    vector<Move> quiet;
+    bool hasHashMove;
+    Move hashMove;
+    Move killers[2];
+    size_t killerCount;
+    ExchangeInfo info;
+    bool defending;
+    vector<pair<Move, PickerStage>> defences;
+    size_t defenceIndex;
+
+    bool stopsWin(const Move &move) const {
+    /**
+     * Tells whether the opponent's threat to win is gone after the move, by updating the masks.
+     */
+        Player player = state.currentPlayer;
+        Player opponent = (player == RED) ? BLUE : RED;
+        uint32_t from = 1u << (move.x1 * BOARD_SIZE + move.y1);
+        uint32_t to = 1u << (move.x2 * BOARD_SIZE + move.y2);
+        ExchangeInfo after = info;
+        after.pieces[player] = (after.pieces[player] & ~from) | to;
+        if (after.masters[player] & from) {
+            after.masters[player] = to;
+        }
+        after.pieces[opponent] &= ~to;
+        after.masters[opponent] &= ~to;
+        return !threatensWin(after, opponent);
+    }
+
+    bool nextStaged(Move &move) {
+        switch (currentStage) {
+        case HASH_STAGE:
+            currentStage = WINNING_STAGE;
+            if (hasHashMove) {
+                move = hashMove;
+                lastStage = HASH_STAGE;
+                return true;
+            }
+            // fall through
+        case WINNING_STAGE:
+        case CAPTURE_STAGE:
+            generateTactical();
+            while (index < goodCaptures) {
+                const Move &candidate = tactical[index++];
+                if (!hasHashMove || !sameMove(candidate, hashMove)) {
+                    move = candidate;
+                    lastStage = (index <= winningMoves) ? WINNING_STAGE : CAPTURE_STAGE;
+                    return true;
+                }
+            }
+            if (capturesOnly) {
+                currentStage = DONE_STAGE;
+                return false;
+            }
+            currentStage = KILLER_STAGE;
+            index = 0;
+            // fall through
+        case KILLER_STAGE:
+            if (index < killerCount) {
+                move = killers[index++];
+                lastStage = KILLER_STAGE;
+                return true;
+            }
+            currentStage = QUIET_STAGE;
+            index = 0;
+            {
+                TRACE_SPAN("movegen quiet");
+                forEachMove(false, [this](const Move &candidate) {
+                    if (!(hasHashMove && sameMove(candidate, hashMove)) && !isKiller(candidate)) {
+                        quiet.push_back(candidate);
+                    }
+                    return false;
+                });
+            }
+            // fall through
+        case QUIET_STAGE:
+            if (index < quiet.size()) {
+                move = quiet[index++];
+                lastStage = QUIET_STAGE;
+                return true;
+            }
+            currentStage = BAD_CAPTURE_STAGE;
+            index = goodCaptures;
+            // fall through
+        case BAD_CAPTURE_STAGE:
+            while (index < tactical.size()) {
+                const Move &candidate = tactical[index++];
+                if (!hasHashMove || !sameMove(candidate, hashMove)) {
+                    move = candidate;
+                    lastStage = BAD_CAPTURE_STAGE;
+                    return true;
+                }
+            }
+            currentStage = DONE_STAGE;
+            // fall through
+        default:
+            return false;
+        }
+    }
+
+    bool isKiller(const Move &move) const {
+        for (size_t i = 0; i < killerCount; ++i) {
+            if (sameMove(move, killers[i])) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void generateTactical() {
+        if (tacticalGenerated) {
+            return;
+        }
+        tacticalGenerated = true;
+        TRACE_SPAN("movegen tactical");
+        forEachMove(true, [this](const Move &move) {
+            tactical.push_back(move);
+            return false;
+        });
+        auto firstOther = stable_partition(tactical.begin(), tactical.end(), [this](const Move &move) {
+            return winnerOfMove(state, move) != NONE;
+        });
+        winningMoves = firstOther - tactical.begin();
+        goodCaptures = tactical.size();
+        if (firstOther == tactical.end()) {
+            return;
+        }
+
+        // The other captures by the material they win, the ones that lose material go to the end
+        vector<pair<int, Move>> scored;
+        for (auto move = firstOther; move != tactical.end(); ++move) {
+            scored.push_back({staticExchange(info, state, *move), *move});
+        }
+        stable_sort(scored.begin(), scored.end(), [](const pair<int, Move> &a, const pair<int, Move> &b) {
+            return a.first > b.first;
+        });
+        goodCaptures = winningMoves;
+        for (size_t i = 0; i < scored.size(); ++i) {
+            tactical[winningMoves + i] = scored[i].second;
+            if (scored[i].first >= 0) {
+                ++goodCaptures;
+            }
+        }
+    }
+
+    template <typename Visitor>
+    bool forEachMove(bool tacticalMoves, Visitor visit) {
+    /**
+     * Calls visit with every legal tactical move, or every legal quiet move, in board order.
+     * Stops early and returns true as soon as visit returns true.
+     */
+        bool isRedPlayer = state.currentPlayer == RED;
+        Piece ownMaster = isRedPlayer ? RED_MASTER : BLUE_MASTER;
+        Piece ownStudent = isRedPlayer ? RED_STUDENT : BLUE_STUDENT;
+        int templeY = isRedPlayer ? 0 : 4;
+        Move move;
+        for (int x = 0; x < BOARD_SIZE; ++x) {
+            for (int y = 0; y < BOARD_SIZE; ++y) {
+                Piece piece = state.board[x][y];
+                if (piece != ownMaster && piece != ownStudent) {
+                    continue;
+                }
+                for (int cardIdx = 0; cardIdx < 2; ++cardIdx) {
+                    const MoveCard &card = moveCards[cardIdx];
+                    for (int moveIdx = 0; moveIdx < card.numMoves; ++moveIdx) {
+                        int nx = x + (isRedPlayer ? -card.dx[moveIdx] : card.dx[moveIdx]);
+                        int ny = y + (isRedPlayer ? -card.dy[moveIdx] : card.dy[moveIdx]);
+                        if (nx < 0 || nx >= BOARD_SIZE || ny < 0 || ny >= BOARD_SIZE) {
+                            continue;
+                        }
+                        Piece target = state.board[nx][ny];
+                        if (target == ownMaster || target == ownStudent) {
+                            continue;
+                        }
+                        bool tacticalMove = target != EMPTY || (piece == ownMaster && nx == 2 && ny == templeY);
+                        if (tacticalMove != tacticalMoves) {
+                            continue;
+                        }
+                        move.x1 = x;
+                        move.y1 = y;
+                        move.x2 = nx;
+                        move.y2 = ny;
+                        move.usedCard = card;
+                        move.usedPiece = piece;
+                        if (visit(move)) {
+                            return true;
+                        }
+                    }
+                }
+            }
+        }
+        return false;
+    }
+};
+
+int quiescence(GameState &state, int alpha, int beta, bool maximizingPlayer, MoveCard *redMoveCards, MoveCard *blueMoveCards, int ply,
+               bool quietDefences = true) {
+/**
+ * Searches the captures left at the horizon of miniMaxAlphaBeta, so a position isn't evaluated in the
+ * middle of an exchange. The side to move may stand on the static evaluation instead of capturing.
+ * Only wins on the spot and captures that don't lose material by static exchange evaluation are
+ * searched, which keeps the tree small since every capture removes a piece. When the opponent
+ * threatens to win at the horizon, the moves that stop the threat are searched instead. Further down
+ * only captures are, since quiet defences can threaten in turn and the exchange would never end.
+
+ * @param state The current game state.
+ * @param alpha The current best value for the maximizing player.
+ * @param beta The current best value for the minimizing player.
+ * @param maximizingPlayer true if red is to move.
+ * @param redMoveCards A pointer to an array of MoveCard objects for the red player.
+ * @param blueMoveCards A pointer to an array of MoveCard objects for the blue player.
+ * @param ply The number of moves played from the root of the search.
+ * @param quietDefences false below the horizon node, where a threat is only answered by captures.
+ * @return The evaluation score of the position once the captures are played out.
+ */
+    searchStats.nodes++;
+    if (ply <= MAX_PLY) {
+        principalVariation[ply].clear();
+    }
+    if (searchInterrupted()) {
+        return 0;
+    }
+    if (state.winner != NONE) {
+        return winScore(state.winner, ply);
+    }
+
+    state.currentPlayer = maximizingPlayer ? RED : BLUE;
+    int standPat = staticEvaluation(state, redMoveCards, blueMoveCards, ply);
+    if (ply >= MAX_PLY) {
+        return standPat;
+    }
+
+    MovePicker picker(state, redMoveCards, blueMoveCards, nullptr, ply, true);
+    Move move;
+    if (picker.findWinningMove(move)) {
+        return winScore(state.currentPlayer, ply + 1);
+    }
+
+    // Standing pat would ignore a threat to win, so every move that stops it is searched instead
+    Player opponent = maximizingPlayer ? BLUE : RED;
+    if (quietDefences && picker.canWin(opponent)) {
+        if (picker.defendAgainstWin() == 0) {
+            return winScore(opponent, ply + 2);
+        }
+        standPat = maximizingPlayer ? numeric_limits<int>::min() : numeric_limits<int>::max();
+    }
+
+    int bestScore = standPat;
+    if (maximizingPlayer) {
+        if (bestScore >= beta) {
+            return bestScore;
+        }
+        alpha = max(alpha, bestScore);
+    } else {
+        if (bestScore <= alpha) {
+            return bestScore;
+        }
+        beta = min(beta, bestScore);
+    }
+
+    while (picker.next(move)) {
+        GameState nextState = state;
+        pushMoveAccumulator(ply, state, move);
+        applyMove(nextState, move, redMoveCards, blueMoveCards);
+        int eval = quiescence(nextState, alpha, beta, !maximizingPlayer, redMoveCards, blueMoveCards, ply + 1, false);
+        if (searchControl.aborted) {
+            return 0;
+        }
+        if (maximizingPlayer) {
+            bestScore = max(bestScore, eval);
+            alpha = max(alpha, eval);
+        } else {
+            bestScore = min(bestScore, eval);
+            beta = min(beta, eval);
+        }
+        if (beta <= alpha) {
+            break;
+        }
+    }
+    return bestScore;
+}
+
+int miniMaxAlphaBeta(GameState &state, int depth, int alpha, int beta, bool maximizingPlayer, Move &bestMove, MoveCard *redMoveCards, MoveCard *blueMoveCards, int ply = 0, bool allowNullMove = true) {
 /**
  * MiniMax algorithm implementation with Alpha-Beta pruning for the Onitama board game.
  * This function performs a depth-limited search using the MiniMax algorithm and Alpha-Beta pruning
  * to find the best move for the current player in the given game state. The search depth can be
- * adjusted to control the complexity and performance of the algorithm.
+ * adjusted to control the complexity and performance of the algorithm. Won games are scored with
+ * winScore, so a win in fewer moves is always preferred and the search stops as soon as a master
+ * is captured or reaches the temple. Null-move pruning, late move reductions, the transposition
+ * table and the network evaluation are used according to searchOptions. Deep results are also
+ * looked up in and added to analysisCache when it is open. When searchControl asks for a stop the search unwinds
+ * at once and the returned score is meaningless; at the root bestMove then holds the best of the
+ * moves that were searched completely.
 
  * @param state The current game state.
  * @param depth The remaining search depth for the algorithm.
@@ -241,50 +1270,591 @@ int miniMaxAlphaBeta(GameState &state, int depth, int alpha, int beta, bool maxi
  * @param bestMove A reference to a Move object, which will store the best move found by the algorithm.
  * @param redMoveCards A pointer to an array of MoveCard objects for the red player.
  * @param blueMoveCards A pointer to an array of MoveCard objects for the blue player.
+ * @param ply The number of moves played from the root of the search, 0 at the root.
+ * @param allowNullMove false directly after a null move, so two passes are never played in a row.
  * @return The evaluation score of the best move found.
  */
 
-    if (depth == 0 || state.winner != NONE) {
-        return evaluate(state, redMoveCards, blueMoveCards);;
+    searchStats.nodes++;
+    if (ply <= MAX_PLY) {
+        principalVariation[ply].clear();
+    }
+    if (searchInterrupted()) {
+        return 0;
+    }
+
+    // The previous move ended the game, nothing below this node can change the result
+    if (state.winner != NONE) {
+        return winScore(state.winner, ply);
+    }
+
+    if (ply == 0 && searchOptions.neuralEvaluation) {
+        refreshAccumulator(accumulatorStack[0], state, redMoveCards, blueMoveCards, maximizingPlayer ? RED : BLUE);
+    }
+
+    if (depth == 0) {
+        if (searchOptions.quiescenceSearch) {
+            return quiescence(state, alpha, beta, maximizingPlayer, redMoveCards, blueMoveCards, ply);
+        }
+        return staticEvaluation(state, redMoveCards, blueMoveCards, ply);
+    }
+
+    // The best this node can do is to win on the next move, if that can't beat the bound stop here
+    if (maximizingPlayer && alpha >= WIN_SCORE - (ply + 1)) {
+        return alpha;
+    }
+    if (!maximizingPlayer && beta <= -(WIN_SCORE - (ply + 1))) {
+        return beta;
+    }
+
+    state.currentPlayer = maximizingPlayer ? RED : BLUE;
+
+    // A position that already occurred on this line, or in the game since the last capture, is a
+    // draw: the side that can do better than a draw will leave the cycle. Right after a null move the
+    // position only looks repeated because a turn was skipped, so it isn't checked there.
+    bool mirrored = false;
+    uint64_t key = positionKey(state, redMoveCards, blueMoveCards, &mirrored);
+    int pieces = countPieces(state, RED) + countPieces(state, BLUE);
+    if (ply > 0 && allowNullMove && isRepetition(key, pieces)) {
+        ++repetitionDraws;
+        return DRAW_SCORE;
+    }
+    HistoryGuard historyGuard(key, pieces);
+    long long repetitionDrawsBefore = repetitionDraws;
+
+    // A stored result that is deep enough settles the node, otherwise its move is searched first
+    int alphaOrig = alpha;
+    int betaOrig = beta;
+    bool hasHashMove = false;
+    Move hashMove;
+    if (searchOptions.transpositionTable) {
+        const TranspositionEntry *entry = probeTranspositionTable(key);
+        // Shallower iterations fill the table first, so the cache is asked whenever it could do better
+        TranspositionEntry cachedEntry;
+        if ((!entry || entry->depth < depth) && probeAnalysisCache(key, depth, cachedEntry) &&
+            (!entry || cachedEntry.depth > entry->depth)) {
+            entry = &cachedEntry;
+        }
+        if (entry) {
+            int score = scoreFromTransposition(entry->score, ply);
+            if (ply > 0 && entry->depth >= depth &&
+                (entry->bound == EXACT_BOUND || (entry->bound == LOWER_BOUND && score >= beta) ||
+                 (entry->bound == UPPER_BOUND && score <= alpha))) {
+                return score;
+            }
+            if (entry->card >= 0) {
+                hashMove.x1 = entry->x1;
+                hashMove.y1 = entry->y1;
+                hashMove.x2 = entry->x2;
+                hashMove.y2 = entry->y2;
+                hashMove.usedCard = FullDeck[entry->card];
+                if (mirrored) {
+                    hashMove = mirrorMove(hashMove);
+                }
+                hasHashMove = true;
+            }
+        }
+    }
+
+    MovePicker picker(state, redMoveCards, blueMoveCards, hasHashMove ? &hashMove : nullptr, ply);
+
+    // An immediate win can't be improved on, so the rest of the subtree is never searched
+    Move winningMove;
+    if (picker.findWinningMove(winningMove)) {
+        bestMove = winningMove;
+        if (ply < MAX_PLY) {
+            principalVariation[ply].assign(1, winningMove);
+        }
+        return winScore(state.currentPlayer, ply + 1);
+    }
+
+    // A player without a legal move has to pass the turn
+    if (!picker.hasMoves()) {
+        GameState nextState = state;
+        nextState.currentPlayer = maximizingPlayer ? BLUE : RED;
+        Move dummyMove;
+        pushPassAccumulator(ply, state.currentPlayer);
+        int eval = miniMaxAlphaBeta(nextState, depth - 1, alpha, beta, !maximizingPlayer, dummyMove, redMoveCards, blueMoveCards, ply + 1);
+        Move passMove = {};
+        passMove.x1 = -1;
+        updatePrincipalVariation(ply, passMove);
+        return eval;
+    }
+
+    // When the opponent threatens to win, only the moves that stop the threat are searched. Without
+    // one the game is lost on the opponent's next move, whatever is played.
+    Player opponent = maximizingPlayer ? BLUE : RED;
+    bool threatened = picker.canWin(opponent);
+    if (threatened && picker.defendAgainstWin() == 0) {
+        if (ply == 0) {
+            generateLegalMoves(state, redMoveCards, blueMoveCards);
+            bestMove = maximizingPlayer ? state.redLegalMoves[0] : state.blueLegalMoves[0];
+        }
+        return winScore(opponent, ply + 2);
+    }
+
+    // Null move: if passing the turn still doesn't let the opponent get back inside the window,
+    // a real move will do at least as well and the node can be cut with a shallower search
+    if (allowNullMove && ply > 0 && nullMoveAllowed(state, depth, alpha, beta, maximizingPlayer, redMoveCards, blueMoveCards)) {
+        GameState nextState = state;
+        nextState.currentPlayer = maximizingPlayer ? BLUE : RED;
+        Move dummyMove;
+        int nullDepth = depth - 1 - NULL_MOVE_REDUCTION;
+        pushPassAccumulator(ply, state.currentPlayer);
+        if (maximizingPlayer) {
+            int eval = miniMaxAlphaBeta(nextState, nullDepth, beta - 1, beta, false, dummyMove, redMoveCards, blueMoveCards, ply + 1, false);
+            if (searchControl.aborted) {
+                return 0;
+            }
+            if (eval >= beta) {
+                return beta;
+            }
+        } else {
+            int eval = miniMaxAlphaBeta(nextState, nullDepth, alpha, alpha + 1, true, dummyMove, redMoveCards, blueMoveCards, ply + 1, false);
+            if (searchControl.aborted) {
+                return 0;
+            }
+            if (eval <= alpha) {
+                return alpha;
+            }
+        }
     }
 
+    // Late moves are only reduced when the side to move isn't facing a winning threat
+    bool canReduce = searchOptions.lateMoveReductions && depth >= LMR_MIN_DEPTH && !threatened;
+
     if (maximizingPlayer) {
         int maxEval =  numeric_limits<int>::min();
-        for (const auto &move : state.redLegalMoves) {
+        Move move;
+        for (int moveIdx = 0; picker.next(move); ++moveIdx) {
+            TRACE_SPAN_IF(ply == 0, "root move", moveIdx);
+            // Only the quiet moves ordered late are reduced, the picker hands out captures and killers first.
+            // Captures that lose material come last, close to the horizon they aren't searched at all
+            if (picker.stage() == BAD_CAPTURE_STAGE && depth <= SEE_PRUNE_DEPTH && moveIdx > 0) {
+                break;
+            }
+            bool reduce = canReduce && moveIdx >= LMR_FULL_DEPTH_MOVES && picker.stage() >= QUIET_STAGE;
             GameState nextState = state;
+            pushMoveAccumulator(ply, state, move);
             applyMove(nextState, move, redMoveCards, blueMoveCards);
+            nextState.currentPlayer = BLUE;
             Move dummyMove;
-            int eval = miniMaxAlphaBeta(nextState, depth - 1, alpha, beta, false, dummyMove, redMoveCards, blueMoveCards);
+            int eval;
+            if (reduce) {
+                eval = miniMaxAlphaBeta(nextState, depth - 2, alpha, beta, false, dummyMove, redMoveCards, blueMoveCards, ply + 1);
+                // The reduced search says this move is better than expected, verify at full depth
+                if (eval > alpha) {
+                    eval = miniMaxAlphaBeta(nextState, depth - 1, alpha, beta, false, dummyMove, redMoveCards, blueMoveCards, ply + 1);
+                }
+            } else {
+                eval = miniMaxAlphaBeta(nextState, depth - 1, alpha, beta, false, dummyMove, redMoveCards, blueMoveCards, ply + 1);
+            }
+            // An interrupted subtree has no score, keep the best move among the finished ones
+            if (searchControl.aborted) {
+                return 0;
+            }
             if (eval > maxEval) {
                 maxEval = eval;
                 bestMove = move;
+                updatePrincipalVariation(ply, move);
             }
             alpha =  max(alpha, eval);
             if (beta <= alpha) {
+                if (!isTactical(state, move)) {
+                    storeKillerMove(ply, move);
+                }
                 break;
             }
         }
+        // A result that depends on a repetition draw is neither stored nor cached
+        if (searchOptions.transpositionTable && repetitionDraws == repetitionDrawsBefore) {
+            BoundType bound = (maxEval <= alphaOrig) ? UPPER_BOUND : (maxEval >= beta) ? LOWER_BOUND : EXACT_BOUND;
+            storeTransposition(key, depth, maxEval, bound, bestMove, mirrored, ply);
+            recordAnalysis(key, depth);
+        }
         return maxEval;
     } else {
         int minEval =  numeric_limits<int>::max();
-        for (const auto &move : state.blueLegalMoves) {
+        Move move;
+        for (int moveIdx = 0; picker.next(move); ++moveIdx) {
+            TRACE_SPAN_IF(ply == 0, "root move", moveIdx);
+            // Only the quiet moves ordered late are reduced, the picker hands out captures and killers first.
+            // Captures that lose material come last, close to the horizon they aren't searched at all
+            if (picker.stage() == BAD_CAPTURE_STAGE && depth <= SEE_PRUNE_DEPTH && moveIdx > 0) {
+                break;
+            }
+            bool reduce = canReduce && moveIdx >= LMR_FULL_DEPTH_MOVES && picker.stage() >= QUIET_STAGE;
             GameState nextState = state;
+            pushMoveAccumulator(ply, state, move);
             applyMove(nextState, move, redMoveCards, blueMoveCards);
+            nextState.currentPlayer = RED;
             Move dummyMove;
-            int eval = miniMaxAlphaBeta(nextState, depth - 1, alpha, beta, true, dummyMove, redMoveCards, blueMoveCards);
+            int eval;
+            if (reduce) {
+                eval = miniMaxAlphaBeta(nextState, depth - 2, alpha, beta, true, dummyMove, redMoveCards, blueMoveCards, ply + 1);
+                // The reduced search says this move is better than expected, verify at full depth
+                if (eval < beta) {
+                    eval = miniMaxAlphaBeta(nextState, depth - 1, alpha, beta, true, dummyMove, redMoveCards, blueMoveCards, ply + 1);
+                }
+            } else {
+                eval = miniMaxAlphaBeta(nextState, depth - 1, alpha, beta, true, dummyMove, redMoveCards, blueMoveCards, ply + 1);
+            }
+            // An interrupted subtree has no score, keep the best move among the finished ones
+            if (searchControl.aborted) {
+                return 0;
+            }
             if (eval < minEval) {
                 minEval = eval;
                 bestMove = move;
+                updatePrincipalVariation(ply, move);
             }
             beta =  min(beta, eval);
             if (beta <= alpha) {
+                if (!isTactical(state, move)) {
+                    storeKillerMove(ply, move);
+                }
                 break;
             }
         }
+        // A result that depends on a repetition draw is neither stored nor cached
+        if (searchOptions.transpositionTable && repetitionDraws == repetitionDrawsBefore) {
+            BoundType bound = (minEval >= betaOrig) ? LOWER_BOUND : (minEval <= alpha) ? UPPER_BOUND : EXACT_BOUND;
+            storeTransposition(key, depth, minEval, bound, bestMove, mirrored, ply);
+            recordAnalysis(key, depth);
+        }
         return minEval;
     }
 }
 
 
 
+struct SearchResult {
+    Move bestMove;
+    int score;
+    int depth;
+    long long nodes;
+};
+
+struct SearchLimits {
+    int maxDepth;
+    chrono::steady_clock::time_point deadline;
+    // With a node limit the deadline is ignored and the search is reproducible: the same position,
+    // limits and options give the same move, score and node count on every run and every machine
+    long long maxNodes;
+};
+
+void armSearch(const SearchLimits &limits, const atomic<bool> *stopFlag) {
+/**
+ * Prepares this thread for a new search with the given limits. A node-limited search never looks at
+ * the clock and starts from an empty transposition table, so nothing from earlier searches or from
+ * timing can change its result.
+ */
+    bool nodeLimited = limits.maxNodes > 0;
+    searchStats.nodes = 0;
+    clearKillerMoves();
+    searchControl = {stopFlag, !nodeLimited, limits.deadline, false, limits.maxNodes};
+    if (nodeLimited) {
+        resizeTranspositionTable(TRANSPOSITION_TABLE_MEGABYTES);
+    }
+}
+
+SearchResult iterativeDeepening(GameState state, const SearchLimits &limits, MoveCard *redMoveCards, MoveCard *blueMoveCards,
+                                const atomic<bool> *stopFlag = nullptr, const function<void(const SearchResult &)> &onIteration = nullptr) {
+/**
+ * Searches the position one ply deeper at a time until the depth limit or the deadline is reached,
+ * or until the stop flag is raised.
+ * The deadline is a hard limit: a running iteration is interrupted when it passes. A new iteration is
+ * also not started if the previous one suggests it can't finish in time. The result of the deepest
+ * completed iteration is returned. When the interrupted iteration had already finished searching its
+ * first root move, which is the previous best move thanks to the transposition table, its best move
+ * is used instead.
+
+ * @param state The position to search, with currentPlayer set to the side to move.
+ * @param limits The deepest iteration to run and the time by which the search has to return.
+ * @param redMoveCards A pointer to an array of MoveCard objects for the red player.
+ * @param blueMoveCards A pointer to an array of MoveCard objects for the blue player.
+ * @param stopFlag If given, the search stops soon after the flag becomes true.
+ * @param onIteration If given, called with the result after every completed iteration.
+ * @return The best move, its score, the completed depth and the number of nodes searched.
+ */
+    // Each iteration costs a few times the previous one, don't start one that can't finish
+    const int ITERATION_GROWTH = 3;
+
+    SearchResult result = {};
+    result.bestMove.x1 = -1;
+    armSearch(limits, stopFlag);
+    bool maximizingPlayer = state.currentPlayer == RED;
+
+    for (int depth = 1; depth <= limits.maxDepth; ++depth) {
+        TRACE_SPAN_VALUE("iteration", depth);
+        auto iterationStart = chrono::steady_clock::now();
+        if (depth > 1 && searchControl.hasDeadline && iterationStart >= limits.deadline) {
+            break;
+        }
+
+        Move bestMove;
+        bestMove.x1 = -1;
+        int score = miniMaxAlphaBeta(state, depth, numeric_limits<int>::min(), numeric_limits<int>::max(), maximizingPlayer, bestMove, redMoveCards, blueMoveCards);
+
+        if (searchControl.aborted) {
+            if (bestMove.x1 >= 0 && (searchOptions.transpositionTable || result.bestMove.x1 < 0)) {
+                result.bestMove = bestMove;
+            }
+            break;
+        }
+
+        result.bestMove = bestMove;
+        result.score = score;
+        result.depth = depth;
+        if (onIteration) {
+            result.nodes = searchStats.nodes;
+            onIteration(result);
+        }
+
+        // A forced win or loss won't change with more depth
+        if (abs(score) >= WIN_SCORE - MAX_PLY) {
+            break;
+        }
+
+        auto iterationEnd = chrono::steady_clock::now();
+        if (searchControl.hasDeadline && iterationEnd + (iterationEnd - iterationStart) * ITERATION_GROWTH >= limits.deadline) {
+            break;
+        }
+    }
+
+    // Stopped before a single root move was searched: fall back to any legal move
+    if (result.bestMove.x1 < 0) {
+        generateLegalMoves(state, redMoveCards, blueMoveCards);
+        const vector<Move> &legalMoves = maximizingPlayer ? state.redLegalMoves : state.blueLegalMoves;
+        if (!legalMoves.empty()) {
+            result.bestMove = legalMoves[0];
+        }
+    }
+
+    searchControl = {nullptr, false, {}, false, 0};
+    result.nodes = searchStats.nodes;
+    return result;
+}
+
+// One of the best root moves found by multiPvSearch, with its score and the line the search expects
+struct RootLine {
+    Move move;
+    int score;
+    vector<Move> pv;
+};
+
+struct MultiPvResult {
+    vector<RootLine> lines;
+    int depth;
+    long long nodes;
+};
+
+vector<RootLine> searchRootLines(GameState &state, int depth, size_t lineCount, const vector<Move> &rootMoves,
+                                 MoveCard *redMoveCards, MoveCard *blueMoveCards) {
+/**
+ * Searches every root move to the given depth and keeps the lineCount best ones with exact scores.
+ * Until lineCount lines are found a move is searched with a full window. After that the score of the
+ * worst kept line is the bound: a move that can't beat it fails low cheaply and is dropped, and a
+ * move that does beat it gets an exact score because the window stays open on the other side.
+
+ * @param state The position to search, with currentPlayer set to the side to move.
+ * @param depth The search depth, counting the root move.
+ * @param lineCount The number of lines to keep.
+ * @param rootMoves The legal moves of the position in the order they are searched.
+ * @param redMoveCards A pointer to an array of MoveCard objects for the red player.
+ * @param blueMoveCards A pointer to an array of MoveCard objects for the blue player.
+ * @return The best lines, best first. Empty if the search was interrupted.
+ */
+    bool maximizingPlayer = state.currentPlayer == RED;
+    vector<RootLine> lines;
+    HistoryGuard historyGuard(positionKey(state, redMoveCards, blueMoveCards), countPieces(state, RED) + countPieces(state, BLUE));
+    if (searchOptions.neuralEvaluation) {
+        refreshAccumulator(accumulatorStack[0], state, redMoveCards, blueMoveCards, state.currentPlayer);
+    }
+
+    for (size_t moveIdx = 0; moveIdx < rootMoves.size(); ++moveIdx) {
+        TRACE_SPAN_VALUE("root move", moveIdx);
+        const Move &move = rootMoves[moveIdx];
+        int alpha = numeric_limits<int>::min();
+        int beta = numeric_limits<int>::max();
+        bool full = lines.size() >= lineCount;
+        if (full && maximizingPlayer) {
+            alpha = lines.back().score;
+        } else if (full) {
+            beta = lines.back().score;
+        }
+
+        GameState nextState = state;
+        pushMoveAccumulator(0, state, move);
+        applyMove(nextState, move, redMoveCards, blueMoveCards);
+        nextState.currentPlayer = maximizingPlayer ? BLUE : RED;
+        Move dummyMove;
+        int eval = miniMaxAlphaBeta(nextState, depth - 1, alpha, beta, !maximizingPlayer, dummyMove, redMoveCards, blueMoveCards, 1);
+        if (searchControl.aborted) {
+            return {};
+        }
+        if (full && (maximizingPlayer ? eval <= alpha : eval >= beta)) {
+            continue;
+        }
+
+        RootLine line = {move, eval, {move}};
+        line.pv.insert(line.pv.end(), principalVariation[1].begin(), principalVariation[1].end());
+        auto position = find_if(lines.begin(), lines.end(), [&](const RootLine &other) {
+            return maximizingPlayer ? eval > other.score : eval < other.score;
+        });
+        lines.insert(position, line);
+        if (lines.size() > lineCount) {
+            lines.pop_back();
+        }
+    }
+    return lines;
+}
+
+MultiPvResult multiPvSearch(GameState state, int lineCount, const SearchLimits &limits, MoveCard *redMoveCards, MoveCard *blueMoveCards,
+                            const atomic<bool> *stopFlag = nullptr) {
+/**
+ * Finds the lineCount best moves of the position, each with its exact score and principal variation,
+ * in a single search per depth instead of one search per candidate move. Depth, deadline and stop
+ * flag work as in iterativeDeepening. Every iteration searches the lines of the previous one first,
+ * so the bound that cuts off the remaining moves is tight from the start.
+
+ * @param state The position to search, with currentPlayer set to the side to move.
+ * @param lineCount The number of moves to return, fewer if the position has fewer legal moves.
+ * @param limits The deepest iteration to run and the time by which the search has to return.
+ * @param redMoveCards A pointer to an array of MoveCard objects for the red player.
+ * @param blueMoveCards A pointer to an array of MoveCard objects for the blue player.
+ * @param stopFlag If given, the search stops soon after the flag becomes true.
+ * @return The lines of the deepest completed iteration, best first, with that depth and the node count.
+ */
+    const int ITERATION_GROWTH = 3;
+
+    MultiPvResult result = {};
+    armSearch(limits, stopFlag);
+
+    generateLegalMoves(state, redMoveCards, blueMoveCards);
+    vector<Move> rootMoves = (state.currentPlayer == RED) ? state.redLegalMoves : state.blueLegalMoves;
+    stable_partition(rootMoves.begin(), rootMoves.end(), [&state](const Move &move) {
+        return isCapture(state, move);
+    });
+
+    for (int depth = 1; depth <= limits.maxDepth && lineCount > 0 && !rootMoves.empty(); ++depth) {
+        TRACE_SPAN_VALUE("iteration", depth);
+        auto iterationStart = chrono::steady_clock::now();
+        if (depth > 1 && searchControl.hasDeadline && iterationStart >= limits.deadline) {
+            break;
+        }
+
+        vector<RootLine> lines = searchRootLines(state, depth, lineCount, rootMoves, redMoveCards, blueMoveCards);
+        if (searchControl.aborted) {
+            break;
+        }
+        result.lines = lines;
+        result.depth = depth;
+
+        // The lines found go first next time, in their order, the other moves keep theirs
+        for (auto line = lines.rbegin(); line != lines.rend(); ++line) {
+            auto found = find_if(rootMoves.begin(), rootMoves.end(), [&line](const Move &move) {
+                return move.x1 == line->move.x1 && move.y1 == line->move.y1 && move.x2 == line->move.x2 &&
+                       move.y2 == line->move.y2 && move.usedCard == line->move.usedCard;
+            });
+            rotate(rootMoves.begin(), found, found + 1);
+        }
+
+        // More depth won't change lines that all end in a forced win or loss
+        bool allDecided = all_of(lines.begin(), lines.end(), [](const RootLine &line) {
+            return abs(line.score) >= WIN_SCORE - MAX_PLY;
+        });
+        if (allDecided) {
+            break;
+        }
+
+        auto iterationEnd = chrono::steady_clock::now();
+        if (searchControl.hasDeadline && iterationEnd + (iterationEnd - iterationStart) * ITERATION_GROWTH >= limits.deadline) {
+            break;
+        }
+    }
+
+    searchControl = {nullptr, false, {}, false, 0};
+    result.nodes = searchStats.nodes;
+    return result;
+}
+
+// A search running on its own thread, started with startSearch
+class SearchHandle {
+public:
+    SearchHandle(const GameState &state, MoveCard *redMoveCards, MoveCard *blueMoveCards, const SearchLimits &limits,
+                 function<void(const SearchResult &)> onIteration)
+        : stopFlag(false), done(false) {
+        copy(redMoveCards, redMoveCards + 2, this->redMoveCards);
+        copy(blueMoveCards, blueMoveCards + 2, this->blueMoveCards);
+
+        // The search thread borrows the starting thread's transposition table and hands it back at the end
+        vector<TranspositionEntry> *callerTable = &transpositionTable;
+        vector<HistoryEntry> gameHistory = positionHistory;
+        worker = thread([this, state, limits, onIteration, callerTable, gameHistory]() {
+            transpositionTable.swap(*callerTable);
+            positionHistory = gameHistory;
+            SearchResult finalResult = iterativeDeepening(state, limits, this->redMoveCards, this->blueMoveCards, &stopFlag, onIteration);
+            transpositionTable.swap(*callerTable);
+
+            lock_guard<mutex> lock(resultMutex);
+            result = finalResult;
+            done = true;
+        });
+    }
+
+    ~SearchHandle() {
+        stop();
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+
+    // Asks the search to stop, it returns its best move within a fraction of a millisecond
+    void stop() {
+        stopFlag.store(true, memory_order_relaxed);
+    }
+
+    bool finished() {
+        return done.load();
+    }
+
+    // Waits for the search to end and returns its result
+    SearchResult wait() {
+        if (worker.joinable()) {
+            worker.join();
+        }
+        lock_guard<mutex> lock(resultMutex);
+        return result;
+    }
+
+private:
+    MoveCard redMoveCards[2];
+    MoveCard blueMoveCards[2];
+    atomic<bool> stopFlag;
+    atomic<bool> done;
+    SearchResult result;
+    mutex resultMutex;
+    thread worker;
+};
+
+unique_ptr<SearchHandle> startSearch(const GameState &state, MoveCard *redMoveCards, MoveCard *blueMoveCards, const SearchLimits &limits,
+                                     function<void(const SearchResult &)> onIteration = nullptr) {
+/**
+ * Starts searching the position on a background thread and returns right away.
+ * onIteration is called from the search thread after every completed iteration. The search ends at
+ * the depth limit, at the deadline, or when stop() is called on the handle; wait() returns the result.
+ * While the search runs, the calling thread must not search itself, since its transposition table is
+ * on loan to the search thread.
+
+ * @param state The position to search, with currentPlayer set to the side to move.
+ * @param redMoveCards A pointer to an array of MoveCard objects for the red player, copied.
+ * @param blueMoveCards A pointer to an array of MoveCard objects for the blue player, copied.
+ * @param limits The deepest iteration to run and the hard deadline.
+ * @param onIteration Optional progress callback.
+ * @return The handle of the running search.
+ */
+    return unique_ptr<SearchHandle>(new SearchHandle(state, redMoveCards, blueMoveCards, limits, onIteration));
+}
+
 #endif // ONITAMA_H
\ No newline at end of file
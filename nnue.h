@@ -0,0 +1,283 @@
+#ifndef NNUE_H
+#define NNUE_H
+
+#include <iostream>
+using namespace std;
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+#include "components.h"
+
+// Small efficiently updatable neural network (NNUE) evaluator.
+//
+// Input features are one-hot: a piece of each kind on each square, each card in each player's hand,
+// and blue to move. The first layer is only a sum of the weight rows of the active features, kept in
+// an accumulator that a move updates by subtracting and adding a few rows instead of recomputing it.
+// The accumulator is clipped to 0..127 and fed through a small int8 layer and an int8 output layer.
+// With AVX2 (-mavx2) the layers run on 256-bit vectors, otherwise on the scalar fallback, and both
+// give exactly the same result.
+//
+// Weights file, all values little-endian:
+//   char[8]  magic "ONINNUE1"
+//   uint32   NNUE_INPUTS, NNUE_HIDDEN, NNUE_LAYER2
+//   int16    featureWeights[NNUE_INPUTS][NNUE_HIDDEN]
+//   int16    featureBias[NNUE_HIDDEN]
+//   int8     layer2Weights[NNUE_LAYER2][NNUE_HIDDEN]
+//   int32    layer2Bias[NNUE_LAYER2]
+//   int8     outputWeights[NNUE_LAYER2]
+//   int32    outputBias
+// The output is divided by NNUE_OUTPUT_DIVISOR and is a score from red's point of view in the same
+// units as evaluate.
+
+const int NNUE_PIECE_FEATURES = 4 * BOARD_SIZE * BOARD_SIZE;
+const int NNUE_RED_CARD_FEATURES = NNUE_PIECE_FEATURES;
+const int NNUE_BLUE_CARD_FEATURES = NNUE_RED_CARD_FEATURES + DECK_SIZE;
+const int NNUE_BLUE_TO_MOVE_FEATURE = NNUE_BLUE_CARD_FEATURES + DECK_SIZE;
+const int NNUE_INPUTS = NNUE_BLUE_TO_MOVE_FEATURE + 1;
+const int NNUE_HIDDEN = 128;
+const int NNUE_LAYER2 = 32;
+// Hidden activations are clipped to 0..NNUE_ACTIVATION_MAX, layer 2 sums are shifted down before clipping
+const int NNUE_ACTIVATION_MAX = 127;
+const int NNUE_LAYER2_SHIFT = 6;
+const int NNUE_OUTPUT_DIVISOR = 64;
+const char NNUE_MAGIC[8] = {'O', 'N', 'I', 'N', 'N', 'U', 'E', '1'};
+
+struct NnueNetwork {
+    alignas(32) int16_t featureWeights[NNUE_INPUTS][NNUE_HIDDEN];
+    alignas(32) int16_t featureBias[NNUE_HIDDEN];
+    alignas(32) int8_t layer2Weights[NNUE_LAYER2][NNUE_HIDDEN];
+    int32_t layer2Bias[NNUE_LAYER2];
+    alignas(32) int8_t outputWeights[NNUE_LAYER2];
+    int32_t outputBias;
+    bool loaded;
+};
+
+// The network used by every search thread, read once at startup with loadNetwork
+NnueNetwork network = {};
+
+// First layer sums of one position
+struct NnueAccumulator {
+    alignas(32) int16_t values[NNUE_HIDDEN];
+};
+
+int pieceFeature(Piece piece, int x, int y) {
+    return (piece - 1) * BOARD_SIZE * BOARD_SIZE + x * BOARD_SIZE + y;
+}
+
+bool loadNetwork(const string &path) {
+/**
+ * Reads the network weights from a file in the format described at the top of this file.
+ * The file has to match this build's layer sizes exactly.
+
+ * @param path The weights file.
+ * @return false if the file can't be read or doesn't match, the network is then left unloaded.
+ */
+    network.loaded = false;
+    ifstream file(path, ios::binary);
+    if (!file) {
+        cerr << "Could not open the network file " << path << endl;
+        return false;
+    }
+
+    char magic[8];
+    uint32_t sizes[3];
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char *>(sizes), sizeof(sizes));
+    if (!file || memcmp(magic, NNUE_MAGIC, sizeof(magic)) != 0 ||
+        sizes[0] != NNUE_INPUTS || sizes[1] != NNUE_HIDDEN || sizes[2] != NNUE_LAYER2) {
+        cerr << "The network file " << path << " doesn't match this build" << endl;
+        return false;
+    }
+
+    file.read(reinterpret_cast<char *>(network.featureWeights), sizeof(network.featureWeights));
+    file.read(reinterpret_cast<char *>(network.featureBias), sizeof(network.featureBias));
+    file.read(reinterpret_cast<char *>(network.layer2Weights), sizeof(network.layer2Weights));
+    file.read(reinterpret_cast<char *>(network.layer2Bias), sizeof(network.layer2Bias));
+    file.read(reinterpret_cast<char *>(network.outputWeights), sizeof(network.outputWeights));
+    file.read(reinterpret_cast<char *>(&network.outputBias), sizeof(network.outputBias));
+    if (!file) {
+        cerr << "The network file " << path << " is truncated" << endl;
+        return false;
+    }
+    network.loaded = true;
+    return true;
+}
+
+bool saveNetwork(const string &path) {
+/**
+ * Writes the current network in the format loadNetwork reads, for tools that train or convert weights.
+ */
+    ofstream file(path, ios::binary);
+    uint32_t sizes[3] = {NNUE_INPUTS, NNUE_HIDDEN, NNUE_LAYER2};
+    file.write(NNUE_MAGIC, sizeof(NNUE_MAGIC));
+    file.write(reinterpret_cast<const char *>(sizes), sizeof(sizes));
+    file.write(reinterpret_cast<const char *>(network.featureWeights), sizeof(network.featureWeights));
+    file.write(reinterpret_cast<const char *>(network.featureBias), sizeof(network.featureBias));
+    file.write(reinterpret_cast<const char *>(network.layer2Weights), sizeof(network.layer2Weights));
+    file.write(reinterpret_cast<const char *>(network.layer2Bias), sizeof(network.layer2Bias));
+    file.write(reinterpret_cast<const char *>(network.outputWeights), sizeof(network.outputWeights));
+    file.write(reinterpret_cast<const char *>(&network.outputBias), sizeof(network.outputBias));
+    return static_cast<bool>(file);
+}
+
+void addFeature(NnueAccumulator &accumulator, int feature) {
+    const int16_t *row = network.featureWeights[feature];
+#ifdef __AVX2__
+    for (int i = 0; i < NNUE_HIDDEN; i += 16) {
+        __m256i sum = _mm256_add_epi16(_mm256_load_si256((const __m256i *)(accumulator.values + i)),
+                                       _mm256_load_si256((const __m256i *)(row + i)));
+        _mm256_store_si256((__m256i *)(accumulator.values + i), sum);
+    }
+#else
+    for (int i = 0; i < NNUE_HIDDEN; ++i) {
+        accumulator.values[i] += row[i];
+    }
+#endif
+}
+
+void removeFeature(NnueAccumulator &accumulator, int feature) {
+    const int16_t *row = network.featureWeights[feature];
+#ifdef __AVX2__
+    for (int i = 0; i < NNUE_HIDDEN; i += 16) {
+        __m256i difference = _mm256_sub_epi16(_mm256_load_si256((const __m256i *)(accumulator.values + i)),
+                                              _mm256_load_si256((const __m256i *)(row + i)));
+        _mm256_store_si256((__m256i *)(accumulator.values + i), difference);
+    }
+#else
+    for (int i = 0; i < NNUE_HIDDEN; ++i) {
+        accumulator.values[i] -= row[i];
+    }
+#endif
+}
+
+void refreshAccumulator(NnueAccumulator &accumulator, const GameState &state, MoveCard *redMoveCards, MoveCard *blueMoveCards, Player toMove) {
+/**
+ * Builds the accumulator of a position from scratch: the bias plus the rows of all active features.
+
+ * @param[out] accumulator The accumulator to fill.
+ * @param state The position.
+ * @param redMoveCards A pointer to an array of the red player's two MoveCards.
+ * @param blueMoveCards A pointer to an array of the blue player's two MoveCards.
+ * @param toMove The player to move.
+ */
+    memcpy(accumulator.values, network.featureBias, sizeof(accumulator.values));
+    for (int x = 0; x < BOARD_SIZE; ++x) {
+        for (int y = 0; y < BOARD_SIZE; ++y) {
+            if (state.board[x][y] != EMPTY) {
+                addFeature(accumulator, pieceFeature(state.board[x][y], x, y));
+            }
+        }
+    }
+    for (int i = 0; i < 2; ++i) {
+        addFeature(accumulator, NNUE_RED_CARD_FEATURES + cardIndex(redMoveCards[i]));
+        addFeature(accumulator, NNUE_BLUE_CARD_FEATURES + cardIndex(blueMoveCards[i]));
+    }
+    if (toMove == BLUE) {
+        addFeature(accumulator, NNUE_BLUE_TO_MOVE_FEATURE);
+    }
+}
+
+void updateAccumulator(const NnueAccumulator &parent, NnueAccumulator &child, const GameState &state, const Move &move) {
+/**
+ * Derives the accumulator after a move from the one before it: the moving piece leaves its square,
+ * a captured piece leaves the board, the moving piece arrives and the side to move changes.
+ * The hands don't change inside the search, so the card features stay as they are.
+
+ * @param parent The accumulator of the position before the move.
+ * @param[out] child The accumulator of the position after the move.
+ * @param state The position before the move.
+ * @param move The move, which must be legal in state.
+ */
+    child = parent;
+    Piece movingPiece = state.board[move.x1][move.y1];
+    Piece targetPiece = state.board[move.x2][move.y2];
+    removeFeature(child, pieceFeature(movingPiece, move.x1, move.y1));
+    if (targetPiece != EMPTY) {
+        removeFeature(child, pieceFeature(targetPiece, move.x2, move.y2));
+    }
+    addFeature(child, pieceFeature(movingPiece, move.x2, move.y2));
+    if (state.currentPlayer == RED) {
+        addFeature(child, NNUE_BLUE_TO_MOVE_FEATURE);
+    } else {
+        removeFeature(child, NNUE_BLUE_TO_MOVE_FEATURE);
+    }
+}
+
+void passAccumulator(const NnueAccumulator &parent, NnueAccumulator &child, Player toMove) {
+/**
+ * Derives the accumulator after a pass or a null move, where only the side to move changes.
+ * toMove is the player who passes.
+ */
+    child = parent;
+    if (toMove == RED) {
+        addFeature(child, NNUE_BLUE_TO_MOVE_FEATURE);
+    } else {
+        removeFeature(child, NNUE_BLUE_TO_MOVE_FEATURE);
+    }
+}
+
+int32_t dotActivations(const uint8_t *activations, const int8_t *weights, int size) {
+/**
+ * Sum of activations[i] * weights[i]. Activations are at most 127, so two products always fit the
+ * int16 pairs AVX2 adds them into.
+ */
+#ifdef __AVX2__
+    __m256i sum = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi16(1);
+    for (int i = 0; i < size; i += 32) {
+        __m256i pairs = _mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i *)(activations + i)),
+                                             _mm256_loadu_si256((const __m256i *)(weights + i)));
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(pairs, ones));
+    }
+    __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(half);
+#else
+    int32_t sum = 0;
+    for (int i = 0; i < size; ++i) {
+        sum += activations[i] * weights[i];
+    }
+    return sum;
+#endif
+}
+
+int evaluateNetwork(const NnueAccumulator &accumulator) {
+/**
+ * Runs the layers after the accumulator and returns the score from red's point of view.
+ */
+    alignas(32) uint8_t hidden[NNUE_HIDDEN];
+#ifdef __AVX2__
+    const __m256i zero = _mm256_setzero_si256();
+    for (int i = 0; i < NNUE_HIDDEN; i += 32) {
+        __m256i low = _mm256_load_si256((const __m256i *)(accumulator.values + i));
+        __m256i high = _mm256_load_si256((const __m256i *)(accumulator.values + i + 16));
+        // packs saturates to 0..127 after the max with zero; it interleaves 128-bit lanes, permute restores the order
+        __m256i packed = _mm256_packs_epi16(_mm256_max_epi16(low, zero), _mm256_max_epi16(high, zero));
+        packed = _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_store_si256((__m256i *)(hidden + i), packed);
+    }
+#else
+    for (int i = 0; i < NNUE_HIDDEN; ++i) {
+        hidden[i] = (uint8_t)min<int>(max<int>(accumulator.values[i], 0), NNUE_ACTIVATION_MAX);
+    }
+#endif
+
+    alignas(32) uint8_t layer2[NNUE_LAYER2];
+    for (int j = 0; j < NNUE_LAYER2; ++j) {
+        int32_t sum = network.layer2Bias[j] + dotActivations(hidden, network.layer2Weights[j], NNUE_HIDDEN);
+        layer2[j] = (uint8_t)min(max(sum >> NNUE_LAYER2_SHIFT, 0), NNUE_ACTIVATION_MAX);
+    }
+
+    int32_t output = network.outputBias + dotActivations(layer2, network.outputWeights, NNUE_LAYER2);
+    return output / NNUE_OUTPUT_DIVISOR;
+}
+
+#endif // NNUE_H
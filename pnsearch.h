@@ -0,0 +1,424 @@
+#ifndef PNSEARCH_H
+#define PNSEARCH_H
+
+#include <iostream>
+using namespace std;
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include "components.h"
+#include "hashing.h"
+#include "minimax.h"
+
+// Depth-first proof-number search (df-pn) that proves or disproves a forced win.
+//
+// Cards are drawn from the deck after every move, so a proof has to hold for every card that can
+// be drawn: the draw is treated as a move by the side trying to refute the win. A repeated position
+// on the current line counts as "no win", so proven wins are sound, while disproofs may depend on
+// the line they were found on.
+
+const uint32_t PROOF_INFINITY = 1000000000;
+
+enum ProofResult { PROVEN_WIN, PROVEN_LOSS, UNKNOWN };
+
+struct ProofSearchLimits {
+    long long maxNodes;
+    int maxMilliseconds;
+    size_t tableMegabytes;
+};
+
+struct ProofSearchResult {
+    ProofResult result;
+    int plies;              // upper bound on the length of the forced win, in moves by both sides
+    vector<Move> proofLine; // moves along the proof, the winning side plays the first one
+    long long nodes;
+};
+
+struct ProofEntry {
+    uint64_t key;
+    uint32_t pn;
+    uint32_t dn;
+    uint32_t work;
+    uint16_t distance;
+};
+
+// A position inside the solver. At a decision node currentPlayer is to move; at a draw node
+// currentPlayer has just moved and drawSlot is the slot of their hand waiting for a new card.
+struct SolverPosition {
+    GameState state;
+    int redCards[2];
+    int blueCards[2];
+    uint16_t deck;
+    int drawSlot;
+    Move move;              // the move that led here, drawSlot of the parent tells if it was a draw
+};
+
+uint32_t addProofNumbers(uint32_t a, uint32_t b) {
+    return (a >= PROOF_INFINITY - b) ? PROOF_INFINITY : a + b;
+}
+
+class ProofNumberSolver {
+public:
+    ProofNumberSolver(size_t tableMegabytes) {
+        // Buckets of four entries, the table size is rounded down to a power of two
+        size_t entries = max((size_t)1024, tableMegabytes * 1024 * 1024 / sizeof(ProofEntry));
+        size_t buckets = 1;
+        while (buckets * 2 * BUCKET_SIZE <= entries) {
+            buckets *= 2;
+        }
+        table.assign(buckets * BUCKET_SIZE, ProofEntry());
+        bucketMask = buckets - 1;
+    }
+
+    ProofSearchResult solve(const GameState &root, MoveCard *redMoveCards, MoveCard *blueMoveCards, const vector<MoveCard> &deck, const ProofSearchLimits &limits) {
+    /**
+     * Tries to prove a forced win for either side in the given position.
+     * The side to move is tried first; if it has no forced win the opponent is tried with the
+     * remaining budget. The search gives up with UNKNOWN when the node or time limit runs out.
+
+     * @param root The position to solve, currentPlayer is the side to move.
+     * @param redMoveCards A pointer to an array of MoveCard objects for the red player.
+     * @param blueMoveCards A pointer to an array of MoveCard objects for the blue player.
+     * @param deck The cards that can still be drawn, as in the running game's Deck.
+     * @param limits Node, time and memory limits for the search.
+     * @return PROVEN_WIN or PROVEN_LOSS for the side to move together with the proof line, or UNKNOWN.
+     */
+        nodes = 0;
+        maxNodes = limits.maxNodes;
+        deadline = chrono::steady_clock::now() + chrono::milliseconds(limits.maxMilliseconds);
+        stopped = false;
+
+        SolverPosition position;
+        position.state = root;
+        position.state.winner = NONE;
+        position.drawSlot = -1;
+        position.deck = 0;
+        for (int i = 0; i < 2; ++i) {
+            position.redCards[i] = cardIndex(redMoveCards[i]);
+            position.blueCards[i] = cardIndex(blueMoveCards[i]);
+        }
+        for (const MoveCard &card : deck) {
+            position.deck |= 1 << cardIndex(card);
+        }
+
+        ProofSearchResult result = {UNKNOWN, 0, {}, 0};
+        Player sideToMove = root.currentPlayer;
+        Player opponent = (sideToMove == RED) ? BLUE : RED;
+
+        for (Player attacker : {sideToMove, opponent}) {
+            this->attacker = attacker;
+            // Entries only make sense for the attacker they were computed for
+            fill(table.begin(), table.end(), ProofEntry());
+            path.clear();
+            mid(position, PROOF_INFINITY, PROOF_INFINITY);
+
+            ProofEntry rootEntry = lookup(solverKey(position));
+            if (rootEntry.pn == 0) {
+                result.result = (attacker == sideToMove) ? PROVEN_WIN : PROVEN_LOSS;
+                result.plies = rootEntry.distance;
+                result.proofLine = proofLine(position);
+                break;
+            }
+            if (stopped) {
+                break;
+            }
+        }
+
+        result.nodes = nodes;
+        return result;
+    }
+
+private:
+    static const int BUCKET_SIZE = 4;
+
+    vector<ProofEntry> table;
+    size_t bucketMask;
+    vector<uint64_t> path;
+    Player attacker;
+    long long nodes;
+    long long maxNodes;
+    chrono::steady_clock::time_point deadline;
+    bool stopped;
+
+    uint64_t solverKey(const SolverPosition &position) {
+        // Mirror images share a key: the proof numbers don't depend on which side is which
+        KeyPair keys = boardKeys(position.state);
+        for (int i = 0; i < 2; ++i) {
+            if (!(position.state.currentPlayer == RED && position.drawSlot == i)) {
+                addCardKey(keys, Zobrist.redCard, position.redCards[i]);
+            }
+            if (!(position.state.currentPlayer == BLUE && position.drawSlot == i)) {
+                addCardKey(keys, Zobrist.blueCard, position.blueCards[i]);
+            }
+        }
+        for (int card = 0; card < DECK_SIZE; ++card) {
+            if (position.deck & (1 << card)) {
+                addCardKey(keys, Zobrist.deckCard, card);
+            }
+        }
+        uint64_t key = canonicalKey(keys);
+        // Draw nodes and decision nodes with the same cards must not share an entry
+        if (position.drawSlot >= 0) {
+            key = ~key;
+        }
+        return key;
+    }
+
+    ProofEntry lookup(uint64_t key) {
+        size_t bucket = (key & bucketMask) * BUCKET_SIZE;
+        for (int i = 0; i < BUCKET_SIZE; ++i) {
+            if (table[bucket + i].key == key && table[bucket + i].pn + table[bucket + i].dn > 0) {
+                return table[bucket + i];
+            }
+        }
+        return {key, 1, 1, 0, 0};
+    }
+
+    void store(const ProofEntry &entry) {
+    /**
+     * Stores an entry, replacing the same key or else the entry with the least work behind it.
+     * Solved entries are kept over unsolved ones since they never need to be searched again.
+     */
+        size_t bucket = (entry.key & bucketMask) * BUCKET_SIZE;
+        size_t victim = bucket;
+        uint64_t victimValue = UINT64_MAX;
+        for (int i = 0; i < BUCKET_SIZE; ++i) {
+            const ProofEntry &candidate = table[bucket + i];
+            if (candidate.key == entry.key) {
+                victim = bucket + i;
+                break;
+            }
+            bool solved = candidate.pn == 0 || candidate.dn == 0;
+            uint64_t value = (candidate.pn + candidate.dn == 0) ? 0 : candidate.work + (solved ? PROOF_INFINITY : 0);
+            if (value < victimValue) {
+                victimValue = value;
+                victim = bucket + i;
+            }
+        }
+        table[victim] = entry;
+    }
+
+    bool isOrNode(const SolverPosition &position) {
+        return position.drawSlot < 0 && position.state.currentPlayer == attacker;
+    }
+
+    vector<SolverPosition> expand(const SolverPosition &position) {
+    /**
+     * Generates the children of a node: every legal move at a decision node, every card that can
+     * be drawn at a draw node. A winning move leads straight to a finished game without a draw.
+     */
+        vector<SolverPosition> children;
+
+        if (position.drawSlot >= 0) {
+            for (int card = 0; card < DECK_SIZE; ++card) {
+                if (!(position.deck & (1 << card))) {
+                    continue;
+                }
+                SolverPosition child = position;
+                int *moverCards = (position.state.currentPlayer == RED) ? child.redCards : child.blueCards;
+                moverCards[position.drawSlot] = card;
+                child.drawSlot = -1;
+                child.state.currentPlayer = (position.state.currentPlayer == RED) ? BLUE : RED;
+                children.push_back(child);
+            }
+            return children;
+        }
+
+        MoveCard redMoveCards[2] = {FullDeck[position.redCards[0]], FullDeck[position.redCards[1]]};
+        MoveCard blueMoveCards[2] = {FullDeck[position.blueCards[0]], FullDeck[position.blueCards[1]]};
+        GameState state = position.state;
+        generateLegalMoves(state, redMoveCards, blueMoveCards);
+        const vector<Move> &legalMoves = (state.currentPlayer == RED) ? state.redLegalMoves : state.blueLegalMoves;
+
+        // A player without a legal move passes the turn with the same cards
+        if (legalMoves.empty()) {
+            SolverPosition child = position;
+            child.state.currentPlayer = (position.state.currentPlayer == RED) ? BLUE : RED;
+            children.push_back(child);
+            return children;
+        }
+
+        for (const Move &move : legalMoves) {
+            SolverPosition child = position;
+            child.state.redLegalMoves.clear();
+            child.state.blueLegalMoves.clear();
+            child.move = move;
+            applyMove(child.state, move, redMoveCards, blueMoveCards);
+            if (child.state.winner == NONE) {
+                const int *moverCards = (position.state.currentPlayer == RED) ? position.redCards : position.blueCards;
+                int usedCard = cardIndex(move.usedCard);
+                child.drawSlot = (moverCards[0] == usedCard) ? 0 : 1;
+                // The used card leaves the deck, which is refilled once it runs out
+                child.deck &= ~(1 << usedCard);
+                if (child.deck == 0) {
+                    child.deck = (1 << DECK_SIZE) - 1;
+                }
+            }
+            children.push_back(child);
+        }
+        return children;
+    }
+
+    bool outOfBudget() {
+        if (stopped) {
+            return true;
+        }
+        if (nodes >= maxNodes || ((nodes & 1023) == 0 && chrono::steady_clock::now() >= deadline)) {
+            stopped = true;
+        }
+        return stopped;
+    }
+
+    void mid(const SolverPosition &position, uint32_t thresholdPn, uint32_t thresholdDn) {
+    /**
+     * Multiple iterative deepening step of df-pn: searches below the node until its proof number
+     * reaches thresholdPn or its disproof number reaches thresholdDn, then stores the result.
+     */
+        nodes++;
+        uint64_t key = solverKey(position);
+        long long nodesBefore = nodes;
+
+        // The previous move finished the game
+        if (position.state.winner != NONE) {
+            bool attackerWon = position.state.winner == attacker;
+            store({key, attackerWon ? 0 : PROOF_INFINITY, attackerWon ? PROOF_INFINITY : 0, 1, 0});
+            return;
+        }
+
+        vector<SolverPosition> children = expand(position);
+        vector<uint64_t> childKeys;
+        for (const SolverPosition &child : children) {
+            childKeys.push_back(solverKey(child));
+        }
+
+        bool orNode = isOrNode(position);
+        int moveDistance = (position.drawSlot < 0) ? 1 : 0;
+        path.push_back(key);
+
+        uint32_t pn = 0, dn = 0;
+        uint16_t distance = 0;
+        while (true) {
+            // Collect the children's numbers, a child already on the current line is a draw
+            vector<ProofEntry> entries;
+            for (uint64_t childKey : childKeys) {
+                if (find(path.begin(), path.end(), childKey) != path.end()) {
+                    entries.push_back({childKey, PROOF_INFINITY, 0, 0, 0});
+                } else {
+                    entries.push_back(lookup(childKey));
+                }
+            }
+
+            pn = orNode ? PROOF_INFINITY : 0;
+            dn = orNode ? 0 : PROOF_INFINITY;
+            size_t best = 0;
+            uint32_t secondBest = PROOF_INFINITY;
+            for (size_t i = 0; i < entries.size(); ++i) {
+                uint32_t selectValue = orNode ? entries[i].pn : entries[i].dn;
+                uint32_t bestValue = orNode ? entries[best].pn : entries[best].dn;
+                if (orNode) {
+                    pn = min(pn, entries[i].pn);
+                    dn = addProofNumbers(dn, entries[i].dn);
+                } else {
+                    pn = addProofNumbers(pn, entries[i].pn);
+                    dn = min(dn, entries[i].dn);
+                }
+                if (i == 0) {
+                    continue;
+                }
+                if (selectValue < bestValue) {
+                    secondBest = bestValue;
+                    best = i;
+                } else if (selectValue < secondBest) {
+                    secondBest = selectValue;
+                }
+            }
+            if (entries.size() == 1) {
+                secondBest = PROOF_INFINITY;
+            }
+
+            if (pn == 0 || dn == 0) {
+                distance = solvedDistance(entries, orNode, pn == 0) + moveDistance;
+            }
+            if (pn >= thresholdPn || dn >= thresholdDn || outOfBudget()) {
+                break;
+            }
+
+            uint32_t childPn, childDn;
+            if (orNode) {
+                childPn = min(thresholdPn, addProofNumbers(secondBest, 1));
+                childDn = (thresholdDn == PROOF_INFINITY) ? PROOF_INFINITY : thresholdDn - dn + entries[best].dn;
+            } else {
+                childDn = min(thresholdDn, addProofNumbers(secondBest, 1));
+                childPn = (thresholdPn == PROOF_INFINITY) ? PROOF_INFINITY : thresholdPn - pn + entries[best].pn;
+            }
+            mid(children[best], childPn, childDn);
+        }
+
+        path.pop_back();
+        store({key, pn, dn, (uint32_t)min<long long>(nodes - nodesBefore + 1, PROOF_INFINITY), distance});
+    }
+
+    uint16_t solvedDistance(const vector<ProofEntry> &entries, bool orNode, bool proven) {
+    /**
+     * Length of a solved node's line: the side that is winning picks its quickest solved child,
+     * the side that is losing holds out with its slowest one.
+     */
+        bool winnerChooses = (orNode == proven);
+        int distance = winnerChooses ? INT32_MAX : 0;
+        for (const ProofEntry &entry : entries) {
+            bool solved = proven ? entry.pn == 0 : entry.dn == 0;
+            if (winnerChooses && solved) {
+                distance = min(distance, (int)entry.distance);
+            } else if (!winnerChooses) {
+                distance = max(distance, (int)entry.distance);
+            }
+        }
+        return (distance == INT32_MAX) ? 0 : distance;
+    }
+
+    vector<Move> proofLine(const SolverPosition &root) {
+    /**
+     * Walks down the proven tree from the root: the winner plays its quickest proven move, the
+     * loser and the card draws pick the child that holds out longest.
+     */
+        vector<Move> line;
+        SolverPosition position = root;
+        while (position.state.winner == NONE && line.size() < (size_t)MAX_PLY) {
+            vector<SolverPosition> children = expand(position);
+            bool winnerToMove = isOrNode(position);
+            int bestIndex = -1;
+            int bestDistance = 0;
+            for (size_t i = 0; i < children.size(); ++i) {
+                ProofEntry entry = lookup(solverKey(children[i]));
+                if (children[i].state.winner == attacker) {
+                    entry.pn = 0;
+                    entry.distance = 0;
+                } else if (entry.pn != 0) {
+                    continue;
+                }
+                if (bestIndex < 0 || (winnerToMove ? entry.distance < bestDistance : entry.distance > bestDistance)) {
+                    bestIndex = i;
+                    bestDistance = entry.distance;
+                }
+            }
+            if (bestIndex < 0) {
+                break;
+            }
+            if (position.drawSlot < 0 && children[bestIndex].state.currentPlayer == position.state.currentPlayer) {
+                line.push_back(children[bestIndex].move);
+            } else if (position.drawSlot < 0 && children[bestIndex].drawSlot < 0 && children[bestIndex].state.winner == NONE) {
+                // a pass, recorded as a move that goes nowhere
+                Move pass = {};
+                pass.x1 = pass.x2 = -1;
+                line.push_back(pass);
+            }
+            position = children[bestIndex];
+        }
+        return line;
+    }
+};
+
+#endif // PNSEARCH_H
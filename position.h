@@ -0,0 +1,218 @@
+#ifndef POSITION_H
+#define POSITION_H
+
+#include <iostream>
+using namespace std;
+
+#include <string>
+#include <vector>
+#include "components.h"
+
+// A position written on one line, in the spirit of chess FEN:
+//
+//     rrRrr/5/5/5/bbBbb Tiger,Dragon Frog,Rabbit Crab r
+//
+// 1. The board, one row per '/' from y = 4 down to y = 0 and x from 0 to 4 within a row, the same
+//    order printBoard uses. r and R are red's students and master, b and B blue's, and a digit
+//    stands for that many empty squares.
+// 2. Red's two cards, then blue's two cards, each pair separated by a comma.
+// 3. The side card, or - when there is none. The game deals new cards from a deck instead, so the
+//    search doesn't use it; it is kept so positions from other sources read and write unchanged.
+// 4. The side to move, r or b.
+//
+// Card names are the names in FullDeck. Any run of spaces or tabs separates the fields.
+
+struct Position {
+    GameState state;
+    MoveCard redMoveCards[2];
+    MoveCard blueMoveCards[2];
+    int sideCard;   // index into FullDeck, -1 for none
+};
+
+int cardByName(const char *name, size_t length) {
+/**
+ * @return The index of the card in FullDeck, or -1 if no card has that name.
+ */
+    for (int i = 0; i < DECK_SIZE; ++i) {
+        if (FullDeck[i].name.size() == length && FullDeck[i].name.compare(0, length, name, length) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool parsePosition(const string &text, Position &position, string &error) {
+/**
+ * Reads a position in the one-line notation. The board must have exactly one master of each side,
+ * neither on the other's temple, and the five cards must all be different.
+
+ * @param text The position, leading and trailing whitespace allowed.
+ * @param[out] position The position read, only complete when true is returned.
+ * @param[out] error What is wrong with the text when false is returned.
+ * @return true if the text is a valid position.
+ */
+    const char *c = text.c_str();
+    auto skipSpaces = [&c]() {
+        while (*c == ' ' || *c == '\t' || *c == '\r' || *c == '\n') {
+            ++c;
+        }
+    };
+    // Reads the name of a card up to the next separator
+    auto readCard = [&c](char separator) {
+        const char *start = c;
+        while (*c && *c != separator && *c != ' ' && *c != '\t' && *c != '\r' && *c != '\n') {
+            ++c;
+        }
+        return cardByName(start, c - start);
+    };
+
+    skipSpaces();
+    GameState &state = position.state;
+    state.board.assign(BOARD_SIZE, vector<Piece>(BOARD_SIZE, EMPTY));
+    state.redLegalMoves.clear();
+    state.blueLegalMoves.clear();
+    int masters[2] = {0, 0};
+    int students[2] = {0, 0};
+    for (int y = BOARD_SIZE - 1; y >= 0; --y) {
+        int x = 0;
+        while (x < BOARD_SIZE) {
+            char square = *c;
+            if (!square) {
+                error = "the board ends in row " + to_string(BOARD_SIZE - y);
+                return false;
+            }
+            ++c;
+            if (square >= '1' && square <= '5') {
+                x += square - '0';
+                continue;
+            }
+            Piece piece;
+            switch (square) {
+                case 'r': piece = RED_STUDENT; ++students[RED]; break;
+                case 'R': piece = RED_MASTER; ++masters[RED]; break;
+                case 'b': piece = BLUE_STUDENT; ++students[BLUE]; break;
+                case 'B': piece = BLUE_MASTER; ++masters[BLUE]; break;
+                default:
+                    error = "unexpected character in row " + to_string(BOARD_SIZE - y);
+                    return false;
+            }
+            state.board[x++][y] = piece;
+        }
+        if (x != BOARD_SIZE) {
+            error = "row " + to_string(BOARD_SIZE - y) + " is longer than " + to_string(BOARD_SIZE) + " squares";
+            return false;
+        }
+        if (y > 0 && *c++ != '/') {
+            error = "expected / after row " + to_string(BOARD_SIZE - y);
+            return false;
+        }
+    }
+    if (masters[RED] != 1 || masters[BLUE] != 1 || students[RED] > 4 || students[BLUE] > 4) {
+        error = "each side needs one master and at most four students";
+        return false;
+    }
+    if (state.board[2][0] == RED_MASTER || state.board[2][BOARD_SIZE - 1] == BLUE_MASTER) {
+        error = "a master stands on the other side's temple, the game is over";
+        return false;
+    }
+
+    int cards[5];
+    for (int i = 0; i < 4; ++i) {
+        if (i % 2 == 0) {
+            skipSpaces();
+        } else if (*c++ != ',') {
+            error = "expected two cards separated by a comma for each side";
+            return false;
+        }
+        cards[i] = readCard(',');
+        if (cards[i] < 0) {
+            error = "unknown card";
+            return false;
+        }
+    }
+    skipSpaces();
+    if (*c == '-') {
+        ++c;
+        cards[4] = -1;
+    } else if ((cards[4] = readCard(' ')) < 0) {
+        error = "unknown side card";
+        return false;
+    }
+    for (int i = 0; i < 5; ++i) {
+        for (int j = i + 1; j < 5; ++j) {
+            if (cards[i] >= 0 && cards[i] == cards[j]) {
+                error = "card " + FullDeck[cards[i]].name + " appears twice";
+                return false;
+            }
+        }
+    }
+
+    skipSpaces();
+    if (*c == 'r' || *c == 'b') {
+        state.currentPlayer = (*c++ == 'r') ? RED : BLUE;
+    } else {
+        error = "expected r or b for the side to move";
+        return false;
+    }
+    skipSpaces();
+    if (*c) {
+        error = "unexpected text after the side to move";
+        return false;
+    }
+
+    state.winner = NONE;
+    position.redMoveCards[0] = FullDeck[cards[0]];
+    position.redMoveCards[1] = FullDeck[cards[1]];
+    position.blueMoveCards[0] = FullDeck[cards[2]];
+    position.blueMoveCards[1] = FullDeck[cards[3]];
+    position.sideCard = cards[4];
+    return true;
+}
+
+string formatPosition(const GameState &state, const MoveCard *redMoveCards, const MoveCard *blueMoveCards, int sideCard = -1) {
+/**
+ * Writes a position in the one-line notation, which parsePosition reads back unchanged.
+ */
+    string text;
+    text.reserve(64);
+    for (int y = BOARD_SIZE - 1; y >= 0; --y) {
+        int empty = 0;
+        for (int x = 0; x < BOARD_SIZE; ++x) {
+            Piece piece = state.board[x][y];
+            if (piece == EMPTY) {
+                ++empty;
+                continue;
+            }
+            if (empty > 0) {
+                text += (char)('0' + empty);
+                empty = 0;
+            }
+            text += (piece == RED_STUDENT) ? 'r' : (piece == RED_MASTER) ? 'R' : (piece == BLUE_STUDENT) ? 'b' : 'B';
+        }
+        if (empty > 0) {
+            text += (char)('0' + empty);
+        }
+        if (y > 0) {
+            text += '/';
+        }
+    }
+    text += ' ';
+    text += redMoveCards[0].name;
+    text += ',';
+    text += redMoveCards[1].name;
+    text += ' ';
+    text += blueMoveCards[0].name;
+    text += ',';
+    text += blueMoveCards[1].name;
+    text += ' ';
+    text += (sideCard >= 0) ? FullDeck[sideCard].name : "-";
+    text += ' ';
+    text += (state.currentPlayer == RED) ? 'r' : 'b';
+    return text;
+}
+
+string formatPosition(const Position &position) {
+    return formatPosition(position.state, position.redMoveCards, position.blueMoveCards, position.sideCard);
+}
+
+#endif // POSITION_H
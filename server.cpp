@@ -0,0 +1,711 @@
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <map>
+#include <limits>
+#include <algorithm>
+#include <string>
+#include <sstream>
+#include <random>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <csignal>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "components.h"
+#include "display.h"
+#include "minimax.h"
+
+// Onitama game server: every connection on the socket plays its own game against the engine.
+// The sockets are served by a single poll() loop, AI moves are searched by a fixed pool of workers.
+using namespace std;
+
+// Number of latency samples kept for the percentile report
+const size_t LATENCY_SAMPLES = 10000;
+
+struct ServerConfig {
+    string unixPath;
+    int port;
+    int workers;
+    size_t queueCapacity;
+    int maxDepth;
+    int defaultDeadlineMs;
+    string cachePath;
+    int maxMoves;   // a game is a draw after this many moves
+};
+
+struct Session {
+    int fd;
+    unsigned long id;
+    string inBuffer;
+    string outBuffer;
+    bool inGame;
+    bool searching;
+    GameState state;
+    MoveCard redMoveCards[2];
+    MoveCard blueMoveCards[2];
+    vector<MoveCard> deck;
+    mt19937 random_engine;
+    // Every position of the game so far, for the search to recognise repetitions
+    vector<HistoryEntry> history;
+    int movesPlayed;
+};
+
+struct SearchJob {
+    unsigned long sessionId;
+    GameState state;
+    MoveCard redMoveCards[2];
+    MoveCard blueMoveCards[2];
+    vector<HistoryEntry> history;
+    chrono::steady_clock::time_point enqueued;
+    chrono::steady_clock::time_point deadline;
+};
+
+struct JobResult {
+    unsigned long sessionId;
+    bool expired;
+    SearchResult search;
+    double latencyMs;
+};
+
+// Fixed pool of search threads fed from a bounded queue. Finished searches are handed back to the
+// I/O loop through a result list and a byte written to the wake-up pipe.
+class EnginePool {
+public:
+    EnginePool(int workers, size_t capacity, int maxDepth, int wakeFd)
+        : capacity(capacity), maxDepth(maxDepth), wakeFd(wakeFd) {
+        for (int i = 0; i < workers; ++i) {
+            threads.emplace_back(&EnginePool::workerLoop, this);
+        }
+    }
+
+    ~EnginePool() {
+        {
+            lock_guard<mutex> lock(jobsMutex);
+            stopping = true;
+        }
+        jobsReady.notify_all();
+        for (auto &thread : threads) {
+            thread.join();
+        }
+    }
+
+    bool submit(const SearchJob &job) {
+    /**
+     * Queues a search request.
+     * @return false if the queue is full and the request was rejected.
+     */
+        {
+            lock_guard<mutex> lock(jobsMutex);
+            if (jobs.size() >= capacity) {
+                return false;
+            }
+            jobs.push_back(job);
+        }
+        jobsReady.notify_one();
+        return true;
+    }
+
+    size_t queueDepth() {
+        lock_guard<mutex> lock(jobsMutex);
+        return jobs.size();
+    }
+
+    vector<JobResult> takeResults() {
+        lock_guard<mutex> lock(resultsMutex);
+        vector<JobResult> finished;
+        finished.swap(results);
+        return finished;
+    }
+
+    size_t workerCount() const {
+        return threads.size();
+    }
+
+private:
+    void workerLoop() {
+        while (true) {
+            SearchJob job;
+            {
+                unique_lock<mutex> lock(jobsMutex);
+                jobsReady.wait(lock, [this] { return stopping || !jobs.empty(); });
+                if (stopping) {
+                    return;
+                }
+                job = jobs.front();
+                jobs.pop_front();
+            }
+
+            JobResult result = {};
+            result.sessionId = job.sessionId;
+            // A request that waited in the queue past its deadline is answered without searching
+            if (chrono::steady_clock::now() >= job.deadline) {
+                result.expired = true;
+            } else {
+                positionHistory = job.history;
+                result.search = iterativeDeepening(job.state, {maxDepth, job.deadline, 0}, job.redMoveCards, job.blueMoveCards);
+            }
+            result.latencyMs = chrono::duration<double, milli>(chrono::steady_clock::now() - job.enqueued).count();
+
+            {
+                lock_guard<mutex> lock(resultsMutex);
+                results.push_back(result);
+            }
+            char wake = 1;
+            (void)write(wakeFd, &wake, 1);
+        }
+    }
+
+    size_t capacity;
+    int maxDepth;
+    int wakeFd;
+    bool stopping = false;
+    vector<thread> threads;
+    deque<SearchJob> jobs;
+    mutex jobsMutex;
+    condition_variable jobsReady;
+    vector<JobResult> results;
+    mutex resultsMutex;
+};
+
+// Move latencies and request counters, only touched by the I/O loop
+struct ServerStats {
+    vector<double> latencies;
+    size_t nextSample = 0;
+    long long completed = 0;
+    long long rejected = 0;
+    long long expired = 0;
+
+    void record(double latencyMs) {
+        if (latencies.size() < LATENCY_SAMPLES) {
+            latencies.push_back(latencyMs);
+        } else {
+            latencies[nextSample] = latencyMs;
+            nextSample = (nextSample + 1) % LATENCY_SAMPLES;
+        }
+    }
+
+    double percentile(double fraction) const {
+        if (latencies.empty()) {
+            return 0.0;
+        }
+        vector<double> sorted = latencies;
+        size_t rank = min(sorted.size() - 1, (size_t)(fraction * sorted.size()));
+        nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+        return sorted[rank];
+    }
+};
+
+volatile sig_atomic_t stopRequested = 0;
+
+void handleStopSignal(int) {
+    stopRequested = 1;
+}
+
+string boardString(const GameState &state) {
+/**
+ * Writes the board as one line of 25 characters, using the same letters as printBoard and the same
+ * order: the row at y = 4 first, x from 0 to 4 within a row.
+ */
+    string text;
+    for (int y = BOARD_SIZE - 1; y >= 0; --y) {
+        for (int x = 0; x < BOARD_SIZE; ++x) {
+            switch (state.board[x][y]) {
+                case RED_STUDENT: text += 'r'; break;
+                case RED_MASTER: text += 'R'; break;
+                case BLUE_STUDENT: text += 'b'; break;
+                case BLUE_MASTER: text += 'B'; break;
+                default: text += '_'; break;
+            }
+        }
+    }
+    return text;
+}
+
+string positionLine(const Session &session) {
+    ostringstream line;
+    line << "position " << boardString(session.state)
+         << " red " << session.redMoveCards[0] << " " << session.redMoveCards[1]
+         << " blue " << session.blueMoveCards[0] << " " << session.blueMoveCards[1]
+         << " turn " << (session.state.currentPlayer == RED ? "red" : "blue");
+    return line.str();
+}
+
+void reply(Session &session, const string &line) {
+    session.outBuffer += line;
+    session.outBuffer += '\n';
+}
+
+void recordPosition(Session &session) {
+/**
+ * Adds the session's current position to its game history.
+ */
+    GameState &state = session.state;
+    session.history.push_back({positionKey(state, session.redMoveCards, session.blueMoveCards),
+                               countPieces(state, RED) + countPieces(state, BLUE)});
+}
+
+void startGame(Session &session, unsigned seed) {
+/**
+ * Sets up a new game for the session the same way main.cpp does: standard starting board, four
+ * cards dealt at random from a fresh deck, red to move.
+ */
+    session.random_engine.seed(seed);
+    session.state = GameState();
+    session.state.winner = NONE;
+    session.state.currentPlayer = RED;
+    session.state.board = {
+    {BLUE_STUDENT, EMPTY, EMPTY, EMPTY, RED_STUDENT},
+    {BLUE_STUDENT, EMPTY, EMPTY, EMPTY, RED_STUDENT},
+    {BLUE_MASTER, EMPTY, EMPTY, EMPTY, RED_MASTER},
+    {BLUE_STUDENT, EMPTY, EMPTY, EMPTY, RED_STUDENT},
+    {BLUE_STUDENT, EMPTY, EMPTY, EMPTY, RED_STUDENT}
+    };
+
+    session.deck = FullDeck;
+    vector<int> randomIndices;
+    generateUniqueRandomIndices(session.deck.size(), randomIndices, session.random_engine);
+    randomIndices.resize(4);
+
+    session.redMoveCards[0] = session.deck[randomIndices[0]];
+    session.redMoveCards[1] = session.deck[randomIndices[1]];
+    session.blueMoveCards[0] = session.deck[randomIndices[2]];
+    session.blueMoveCards[1] = session.deck[randomIndices[3]];
+
+    // remove intitialized cards from the running game deck
+    sort(randomIndices.begin(), randomIndices.end());
+    for (auto it = randomIndices.rbegin(); it != randomIndices.rend(); ++it) {
+        session.deck.erase(session.deck.begin() + *it);
+    }
+
+    session.history.clear();
+    recordPosition(session);
+    session.movesPlayed = 0;
+    session.inGame = true;
+}
+
+void playMove(Session &session, const Move &move) {
+/**
+ * Applies a move to the session's game, deals the mover a new card and passes the turn.
+ */
+    applyMove(session.state, move, session.redMoveCards, session.blueMoveCards);
+
+    MoveCard *moveCards = (session.state.currentPlayer == RED) ? session.redMoveCards : session.blueMoveCards;
+    replaceUsedCard(session.deck, moveCards, move.usedCard, session.random_engine);
+
+    session.state.currentPlayer = (session.state.currentPlayer == RED) ? BLUE : RED;
+    recordPosition(session);
+    ++session.movesPlayed;
+}
+
+void reportGameOver(Session &session, int maxMoves) {
+/**
+ * Ends the session's game once a side has won or the game has reached maxMoves, which is a draw.
+ */
+    if (session.state.winner != NONE) {
+        reply(session, string("winner ") + (session.state.winner == RED ? "red" : "blue"));
+        session.inGame = false;
+    } else if (session.movesPlayed >= maxMoves) {
+        reply(session, "draw after " + to_string(session.movesPlayed) + " moves");
+        session.inGame = false;
+    }
+}
+
+void handleCommand(Session &session, const string &line, EnginePool &pool, ServerStats &stats, const ServerConfig &config, size_t sessionCount) {
+/**
+ * Executes one line of the session protocol.
+ *
+ * new [seed]                  start a new game, red moves first
+ * position                    print the current position
+ * move x1 y1 x2 y2 Card       play a move for the side to move
+ * go [deadline_ms]            let the engine play the side to move within the deadline
+ * stats                       print queue depth, request counters and move latency percentiles
+ * quit                        close the connection
+ */
+    istringstream input(line);
+    string command;
+    input >> command;
+
+    if (command.empty()) {
+        return;
+    }
+
+    if (command == "new") {
+        unsigned seed;
+        if (!(input >> seed)) {
+            seed = chrono::system_clock::now().time_since_epoch().count() + session.id;
+        }
+        if (session.searching) {
+            reply(session, "error search in progress");
+            return;
+        }
+        startGame(session, seed);
+        reply(session, positionLine(session));
+    } else if (command == "position") {
+        if (!session.inGame) {
+            reply(session, "error no game");
+            return;
+        }
+        reply(session, positionLine(session));
+    } else if (command == "move") {
+        Move move;
+        string cardName;
+        if (!(input >> move.x1 >> move.y1 >> move.x2 >> move.y2 >> cardName)) {
+            reply(session, "error usage: move x1 y1 x2 y2 Card");
+            return;
+        }
+        if (!session.inGame || session.searching) {
+            reply(session, session.inGame ? "error search in progress" : "error no game");
+            return;
+        }
+
+        // Only accept a move the engine itself would generate for the side to move
+        generateLegalMoves(session.state, session.redMoveCards, session.blueMoveCards);
+        const vector<Move> &legalMoves = (session.state.currentPlayer == RED) ? session.state.redLegalMoves : session.state.blueLegalMoves;
+        auto legal = find_if(legalMoves.begin(), legalMoves.end(), [&](const Move &candidate) {
+            return candidate.x1 == move.x1 && candidate.y1 == move.y1 && candidate.x2 == move.x2 &&
+                   candidate.y2 == move.y2 && candidate.usedCard.name == cardName;
+        });
+        if (legal == legalMoves.end()) {
+            reply(session, "illegal");
+            return;
+        }
+
+        playMove(session, *legal);
+        reply(session, positionLine(session));
+        reportGameOver(session, config.maxMoves);
+    } else if (command == "go") {
+        int deadlineMs;
+        if (!(input >> deadlineMs)) {
+            deadlineMs = config.defaultDeadlineMs;
+        }
+        if (!session.inGame || session.searching) {
+            reply(session, session.inGame ? "error search in progress" : "error no game");
+            return;
+        }
+
+        SearchJob job;
+        job.sessionId = session.id;
+        job.state = session.state;
+        copy(session.redMoveCards, session.redMoveCards + 2, job.redMoveCards);
+        copy(session.blueMoveCards, session.blueMoveCards + 2, job.blueMoveCards);
+        job.history = session.history;
+        job.enqueued = chrono::steady_clock::now();
+        job.deadline = job.enqueued + chrono::milliseconds(deadlineMs);
+
+        if (!pool.submit(job)) {
+            stats.rejected++;
+            reply(session, "busy");
+            return;
+        }
+        session.searching = true;
+    } else if (command == "stats") {
+        ostringstream line;
+        line << "stats sessions " << sessionCount
+             << " queue " << pool.queueDepth() << "/" << config.queueCapacity
+             << " workers " << pool.workerCount()
+             << " completed " << stats.completed
+             << " rejected " << stats.rejected
+             << " expired " << stats.expired
+             << " p50 " << stats.percentile(0.50)
+             << " p90 " << stats.percentile(0.90)
+             << " p99 " << stats.percentile(0.99)
+             << " max " << stats.percentile(1.0);
+        reply(session, line.str());
+    } else if (command == "quit") {
+        reply(session, "bye");
+        session.inBuffer.clear();
+        shutdown(session.fd, SHUT_RD);
+    } else {
+        reply(session, "error unknown command " + command);
+    }
+}
+
+void deliverResult(Session &session, const JobResult &result, ServerStats &stats, const ServerConfig &config) {
+    session.searching = false;
+    if (result.expired) {
+        stats.expired++;
+        reply(session, "timeout");
+        return;
+    }
+
+    stats.completed++;
+    stats.record(result.latencyMs);
+
+    const SearchResult &search = result.search;
+    generateLegalMoves(session.state, session.redMoveCards, session.blueMoveCards);
+    const vector<Move> &legalMoves = (session.state.currentPlayer == RED) ? session.state.redLegalMoves : session.state.blueLegalMoves;
+
+    // Without a legal move the side to move passes and exchanges its first card
+    if (legalMoves.empty()) {
+        MoveCard *moveCards = (session.state.currentPlayer == RED) ? session.redMoveCards : session.blueMoveCards;
+        replaceUsedCard(session.deck, moveCards, moveCards[0], session.random_engine);
+        session.state.currentPlayer = (session.state.currentPlayer == RED) ? BLUE : RED;
+        recordPosition(session);
+        ++session.movesPlayed;
+        reply(session, "bestmove pass");
+        reply(session, positionLine(session));
+        reportGameOver(session, config.maxMoves);
+        return;
+    }
+
+    ostringstream line;
+    line << "bestmove " << search.bestMove.x1 << " " << search.bestMove.y1 << " "
+         << search.bestMove.x2 << " " << search.bestMove.y2 << " " << search.bestMove.usedCard
+         << " score " << search.score << " depth " << search.depth << " nodes " << search.nodes
+         << " ms " << result.latencyMs;
+    reply(session, line.str());
+
+    playMove(session, search.bestMove);
+    reply(session, positionLine(session));
+    reportGameOver(session, config.maxMoves);
+}
+
+void setNonBlocking(int fd) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+}
+
+int openListenSocket(const ServerConfig &config) {
+/**
+ * Opens the listening socket: a Unix domain socket at config.unixPath, or a TCP socket bound to
+ * 127.0.0.1 when a port is given.
+ * @return The listening file descriptor, or -1 on error.
+ */
+    int fd;
+    if (config.port > 0) {
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) {
+            return -1;
+        }
+        int reuse = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(config.port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(fd, (sockaddr *)&address, sizeof(address)) < 0) {
+            close(fd);
+            return -1;
+        }
+    } else {
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+            return -1;
+        }
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        strncpy(address.sun_path, config.unixPath.c_str(), sizeof(address.sun_path) - 1);
+        unlink(config.unixPath.c_str());
+        if (bind(fd, (sockaddr *)&address, sizeof(address)) < 0) {
+            close(fd);
+            return -1;
+        }
+    }
+
+    if (listen(fd, SOMAXCONN) < 0) {
+        close(fd);
+        return -1;
+    }
+    setNonBlocking(fd);
+    return fd;
+}
+
+void parseServerOptions(int argc, char *argv[], ServerConfig &config) {
+/**
+ * Reads the server options from the command line.
+ *
+ * Supported options: --unix PATH, --port N, --workers N, --queue N, --depth N, --deadline MS, --cache FILE,
+ * --max-moves N
+ */
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--unix" && i + 1 < argc) {
+            config.unixPath = argv[++i];
+        } else if (arg == "--port" && i + 1 < argc) {
+            config.port = stoi(argv[++i]);
+        } else if (arg == "--workers" && i + 1 < argc) {
+            config.workers = max(1, stoi(argv[++i]));
+        } else if (arg == "--queue" && i + 1 < argc) {
+            config.queueCapacity = max(1, stoi(argv[++i]));
+        } else if (arg == "--depth" && i + 1 < argc) {
+            config.maxDepth = stoi(argv[++i]);
+        } else if (arg == "--deadline" && i + 1 < argc) {
+            config.defaultDeadlineMs = stoi(argv[++i]);
+        } else if (arg == "--cache" && i + 1 < argc) {
+            config.cachePath = argv[++i];
+        } else if (arg == "--max-moves" && i + 1 < argc) {
+            config.maxMoves = max(1, stoi(argv[++i]));
+        } else {
+            cerr << "Unknown option: " << arg << endl;
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    ServerConfig config = {"/tmp/onitama.sock", 0, (int)max(1u, thread::hardware_concurrency()), 64, 8, 1000, "", 200};
+    parseServerOptions(argc, argv, config);
+    // Every worker probes the shared cache, so results found for one session help all the others
+    if (!config.cachePath.empty()) {
+        analysisCache.open(config.cachePath, ANALYSIS_CACHE_MEGABYTES, ANALYSIS_FLUSH_SECONDS);
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, handleStopSignal);
+    signal(SIGTERM, handleStopSignal);
+
+    int listenFd = openListenSocket(config);
+    if (listenFd < 0) {
+        cerr << "Could not open the server socket: " << strerror(errno) << endl;
+        return 1;
+    }
+
+    int wakePipe[2];
+    if (pipe(wakePipe) < 0) {
+        cerr << "Could not create the wake-up pipe: " << strerror(errno) << endl;
+        return 1;
+    }
+    setNonBlocking(wakePipe[0]);
+    setNonBlocking(wakePipe[1]);
+
+    EnginePool pool(config.workers, config.queueCapacity, config.maxDepth, wakePipe[1]);
+    ServerStats stats;
+    map<unsigned long, Session> sessions;
+    unsigned long nextSessionId = 1;
+
+    cerr << "Onitama server listening on " << (config.port > 0 ? "127.0.0.1:" + to_string(config.port) : config.unixPath)
+         << " with " << config.workers << " workers" << endl;
+
+    while (!stopRequested) {
+        vector<pollfd> pollFds;
+        vector<unsigned long> pollSessions;
+        pollFds.push_back({listenFd, POLLIN, 0});
+        pollFds.push_back({wakePipe[0], POLLIN, 0});
+        for (auto &entry : sessions) {
+            short events = POLLIN;
+            if (!entry.second.outBuffer.empty()) {
+                events |= POLLOUT;
+            }
+            pollFds.push_back({entry.second.fd, events, 0});
+            pollSessions.push_back(entry.first);
+        }
+
+        if (poll(pollFds.data(), pollFds.size(), -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            cerr << "poll failed: " << strerror(errno) << endl;
+            break;
+        }
+
+        // Accept every pending connection
+        if (pollFds[0].revents & POLLIN) {
+            int clientFd;
+            while ((clientFd = accept(listenFd, nullptr, nullptr)) >= 0) {
+                setNonBlocking(clientFd);
+                Session &session = sessions[nextSessionId];
+                session.fd = clientFd;
+                session.id = nextSessionId++;
+                session.inGame = false;
+                session.searching = false;
+                reply(session, "onitama ready");
+            }
+        }
+
+        // Hand finished searches back to their sessions, the session may have left in the meantime
+        if (pollFds[1].revents & POLLIN) {
+            char drain[256];
+            while (read(wakePipe[0], drain, sizeof(drain)) > 0) {
+            }
+            for (const JobResult &result : pool.takeResults()) {
+                auto found = sessions.find(result.sessionId);
+                if (found != sessions.end()) {
+                    deliverResult(found->second, result, stats, config);
+                }
+            }
+        }
+
+        for (size_t i = 2; i < pollFds.size(); ++i) {
+            auto found = sessions.find(pollSessions[i - 2]);
+            if (found == sessions.end()) {
+                continue;
+            }
+            Session &session = found->second;
+            bool closed = false;
+
+            if (pollFds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+                char buffer[4096];
+                ssize_t received;
+                while ((received = read(session.fd, buffer, sizeof(buffer))) > 0) {
+                    session.inBuffer.append(buffer, received);
+                }
+                if (received == 0 || (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+                    closed = true;
+                }
+
+                size_t newline;
+                while ((newline = session.inBuffer.find('\n')) != string::npos) {
+                    string line = session.inBuffer.substr(0, newline);
+                    session.inBuffer.erase(0, newline + 1);
+                    if (!line.empty() && line.back() == '\r') {
+                        line.pop_back();
+                    }
+                    handleCommand(session, line, pool, stats, config, sessions.size());
+                }
+            }
+
+            // Write the last replies before a closed connection is dropped
+            if (closed && !session.outBuffer.empty()) {
+                (void)write(session.fd, session.outBuffer.data(), session.outBuffer.size());
+            }
+
+            if (closed) {
+                close(session.fd);
+                sessions.erase(found);
+            }
+        }
+
+        // Flush as much output as each socket takes, the rest waits for POLLOUT
+        for (auto it = sessions.begin(); it != sessions.end();) {
+            Session &session = it->second;
+            bool failed = false;
+            while (!session.outBuffer.empty()) {
+                ssize_t sent = write(session.fd, session.outBuffer.data(), session.outBuffer.size());
+                if (sent <= 0) {
+                    failed = sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK;
+                    break;
+                }
+                session.outBuffer.erase(0, sent);
+            }
+            if (failed) {
+                close(session.fd);
+                it = sessions.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    cerr << "completed " << stats.completed << " rejected " << stats.rejected << " expired " << stats.expired
+         << " p50 " << stats.percentile(0.50) << " ms p90 " << stats.percentile(0.90)
+         << " ms p99 " << stats.percentile(0.99) << " ms" << endl;
+
+    for (auto &entry : sessions) {
+        close(entry.second.fd);
+    }
+    close(listenFd);
+    if (config.port == 0) {
+        unlink(config.unixPath.c_str());
+    }
+
+    return 0;
+}
@@ -0,0 +1,214 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <unistd.h>
+#include "components.h"
+#include "display.h"
+#include "minimax.h"
+#include "expectimax.h"
+
+// Searches the starting position of every possible deal and writes one result line per deal.
+// The output file doubles as the checkpoint: deals already in it are skipped when the sweep is
+// started again with the same file, so an interrupted sweep simply resumes.
+using namespace std;
+
+struct SweepConfig {
+    string outputPath;
+    int threads;
+    int maxDepth;
+    int moveTimeMs;       // 0 for no time limit
+    bool searchCardDraws; // search with chance nodes over the card draws, as main.cpp does
+};
+
+// The four cards dealt at the start: two for red, two for blue, as indices into FullDeck
+struct Deal {
+    int index;
+    int redCards[2];
+    int blueCards[2];
+};
+
+vector<Deal> enumerateDeals() {
+/**
+ * Lists every way to deal two cards to each player from the full deck. The order of the two cards
+ * in a hand doesn't matter, which leaves C(16,2) * C(14,2) = 10920 deals, numbered in a fixed order.
+ */
+    vector<Deal> deals;
+    for (int r1 = 0; r1 < DECK_SIZE; ++r1) {
+        for (int r2 = r1 + 1; r2 < DECK_SIZE; ++r2) {
+            for (int b1 = 0; b1 < DECK_SIZE; ++b1) {
+                for (int b2 = b1 + 1; b2 < DECK_SIZE; ++b2) {
+                    if (b1 == r1 || b1 == r2 || b2 == r1 || b2 == r2) {
+                        continue;
+                    }
+                    deals.push_back({(int)deals.size(), {r1, r2}, {b1, b2}});
+                }
+            }
+        }
+    }
+    return deals;
+}
+
+vector<bool> readFinishedDeals(const string &path, size_t dealCount) {
+/**
+ * Reads the deals already swept from an earlier run's output. A last line cut short by an
+ * interruption is removed from the file, so the lines appended next start on a line of their own.
+
+ * @param path The output file, which may not exist yet.
+ * @param dealCount The number of deals.
+ * @return For every deal, whether it has a result line.
+ */
+    vector<bool> finished(dealCount, false);
+    ifstream input(path, ios::binary);
+    if (!input) {
+        return finished;
+    }
+    string contents((istreambuf_iterator<char>(input)), istreambuf_iterator<char>());
+    input.close();
+
+    size_t complete = contents.rfind('\n');
+    complete = (complete == string::npos) ? 0 : complete + 1;
+    if (complete < contents.size() && truncate(path.c_str(), complete) != 0) {
+        cerr << "Could not remove the unfinished last line of " << path << endl;
+    }
+
+    istringstream lines(contents.substr(0, complete));
+    string line;
+    while (getline(lines, line)) {
+        istringstream fields(line);
+        string tag;
+        size_t index;
+        if (fields >> tag >> index && tag == "deal" && index < dealCount) {
+            finished[index] = true;
+        }
+    }
+    return finished;
+}
+
+string sweepDeal(const Deal &deal, const SweepConfig &config) {
+/**
+ * Searches the starting position of a deal, red to move, and formats its result line:
+ * deal N red CARD CARD blue CARD CARD score S depth D move X1 Y1 X2 Y2 CARD nodes N ms T
+ */
+    GameState state;
+    state.currentPlayer = RED;
+    state.winner = NONE;
+    state.board = {
+    {BLUE_STUDENT, EMPTY, EMPTY, EMPTY, RED_STUDENT},
+    {BLUE_STUDENT, EMPTY, EMPTY, EMPTY, RED_STUDENT},
+    {BLUE_MASTER, EMPTY, EMPTY, EMPTY, RED_MASTER},
+    {BLUE_STUDENT, EMPTY, EMPTY, EMPTY, RED_STUDENT},
+    {BLUE_STUDENT, EMPTY, EMPTY, EMPTY, RED_STUDENT}
+    };
+    MoveCard redMoveCards[2] = {FullDeck[deal.redCards[0]], FullDeck[deal.redCards[1]]};
+    MoveCard blueMoveCards[2] = {FullDeck[deal.blueCards[0]], FullDeck[deal.blueCards[1]]};
+
+    // Every deal starts from an empty table, so its result doesn't depend on which deals the
+    // thread happened to search before it
+    clearTranspositionTable();
+    auto start = chrono::steady_clock::now();
+    SearchLimits limits = {config.maxDepth, config.moveTimeMs > 0 ? start + chrono::milliseconds(config.moveTimeMs)
+                                                                  : start + chrono::hours(24), 0};
+    SearchResult result;
+    if (config.searchCardDraws) {
+        vector<MoveCard> deck;
+        for (int card = 0; card < DECK_SIZE; ++card) {
+            if (card != deal.redCards[0] && card != deal.redCards[1] && card != deal.blueCards[0] && card != deal.blueCards[1]) {
+                deck.push_back(FullDeck[card]);
+            }
+        }
+        result = expectimaxSearch(state, limits, redMoveCards, blueMoveCards, deck);
+    } else {
+        result = iterativeDeepening(state, limits, redMoveCards, blueMoveCards);
+    }
+    double elapsedMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    ostringstream line;
+    line << "deal " << deal.index << " red " << redMoveCards[0].name << " " << redMoveCards[1].name
+         << " blue " << blueMoveCards[0].name << " " << blueMoveCards[1].name
+         << " score " << result.score << " depth " << result.depth
+         << " move " << result.bestMove.x1 << " " << result.bestMove.y1 << " " << result.bestMove.x2 << " "
+         << result.bestMove.y2 << " " << result.bestMove.usedCard.name
+         << " nodes " << result.nodes << " ms " << (long long)elapsedMs;
+    return line.str();
+}
+
+void parseSweepOptions(int argc, char *argv[], SweepConfig &config) {
+/**
+ * Reads the sweep options from the command line.
+ *
+ * Supported options: --out FILE, --threads N, --depth N, --ms N, --expectimax
+ */
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--out" && i + 1 < argc) {
+            config.outputPath = argv[++i];
+        } else if (arg == "--threads" && i + 1 < argc) {
+            config.threads = max(1, stoi(argv[++i]));
+        } else if (arg == "--depth" && i + 1 < argc) {
+            config.maxDepth = max(1, stoi(argv[++i]));
+        } else if (arg == "--ms" && i + 1 < argc) {
+            config.moveTimeMs = max(0, stoi(argv[++i]));
+        } else if (arg == "--expectimax") {
+            config.searchCardDraws = true;
+        } else {
+            cerr << "Unknown option: " << arg << endl;
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    SweepConfig config = {"sweep.txt", (int)max(1u, thread::hardware_concurrency()), 8, 0, false};
+    parseSweepOptions(argc, argv, config);
+
+    vector<Deal> deals = enumerateDeals();
+    vector<bool> finished = readFinishedDeals(config.outputPath, deals.size());
+    vector<Deal> pending;
+    for (const Deal &deal : deals) {
+        if (!finished[deal.index]) {
+            pending.push_back(deal);
+        }
+    }
+
+    ofstream output(config.outputPath, ios::app);
+    if (!output) {
+        cerr << "Could not open " << config.outputPath << endl;
+        return 1;
+    }
+    cerr << "Sweeping " << pending.size() << " of " << deals.size() << " deals on " << config.threads << " threads" << endl;
+
+    // Workers take the next pending deal until none are left. Every line is flushed as soon as it is
+    // written, so the file always holds exactly the deals that are done.
+    atomic<size_t> nextDeal(0);
+    mutex outputMutex;
+    size_t written = 0;
+    auto sweepStart = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (int i = 0; i < config.threads; ++i) {
+        workers.emplace_back([&]() {
+            // Allocated up front so the first deal's time limit isn't spent on it
+            resizeTranspositionTable(TRANSPOSITION_TABLE_MEGABYTES);
+            for (size_t next = nextDeal++; next < pending.size(); next = nextDeal++) {
+                string line = sweepDeal(pending[next], config);
+                lock_guard<mutex> lock(outputMutex);
+                output << line << '\n';
+                output.flush();
+                ++written;
+                if (written % 100 == 0 || written == pending.size()) {
+                    double seconds = chrono::duration<double>(chrono::steady_clock::now() - sweepStart).count();
+                    cerr << written << "/" << pending.size() << " deals in " << (long long)seconds << " s" << endl;
+                }
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    return 0;
+}
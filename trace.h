@@ -0,0 +1,159 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <iostream>
+using namespace std;
+
+// Timeline tracing of the search.
+//
+// TRACE_SPAN(name) records how long the rest of the enclosing scope takes. TRACE_SPAN_VALUE adds a
+// number to the span, like the depth of an iteration, and TRACE_SPAN_IF only records when its
+// condition holds. Every thread writes its spans to a ring buffer of its own, without locks, and
+// keeps only the last TRACE_BUFFER_EVENTS of them. writeChromeTrace saves all buffers as Chrome
+// trace JSON for chrome://tracing or ui.perfetto.dev.
+//
+// Tracing is compiled in with -DONITAMA_TRACE. Without it the macros expand to nothing and the
+// search is not changed at all. Span names must be string literals: only the pointer is kept.
+
+#ifdef ONITAMA_TRACE
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <chrono>
+
+// Spans kept per thread, the oldest are overwritten first
+const size_t TRACE_BUFFER_EVENTS = 1 << 18;
+// The value of a span recorded without one
+const int64_t TRACE_NO_VALUE = INT64_MIN;
+
+struct TraceEvent {
+    const char *name;
+    int64_t startNs;    // since traceEpoch
+    int64_t durationNs;
+    int64_t value;
+};
+
+struct TraceBuffer {
+    vector<TraceEvent> events;
+    uint64_t recorded;  // total spans recorded, events[recorded % TRACE_BUFFER_EVENTS] is written next
+    int threadId;
+};
+
+const chrono::steady_clock::time_point traceEpoch = chrono::steady_clock::now();
+
+// Every thread's buffer, kept after the thread ends so its spans can still be written out
+mutex traceBuffersMutex;
+vector<unique_ptr<TraceBuffer>> traceBuffers;
+
+thread_local TraceBuffer *traceBuffer = nullptr;
+
+int64_t traceNow() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - traceEpoch).count();
+}
+
+TraceBuffer *threadTraceBuffer() {
+/**
+ * Returns the calling thread's buffer, registering it on first use.
+ */
+    if (!traceBuffer) {
+        lock_guard<mutex> lock(traceBuffersMutex);
+        traceBuffers.emplace_back(new TraceBuffer{vector<TraceEvent>(TRACE_BUFFER_EVENTS), 0, (int)traceBuffers.size() + 1});
+        traceBuffer = traceBuffers.back().get();
+    }
+    return traceBuffer;
+}
+
+class TraceSpan {
+public:
+    TraceSpan(const char *name, int64_t value = TRACE_NO_VALUE, bool active = true)
+        : name(active ? name : nullptr), value(value), startNs(active ? traceNow() : 0) {}
+
+    ~TraceSpan() {
+        if (!name) {
+            return;
+        }
+        TraceBuffer *buffer = threadTraceBuffer();
+        buffer->events[buffer->recorded % TRACE_BUFFER_EVENTS] = {name, startNs, traceNow() - startNs, value};
+        ++buffer->recorded;
+    }
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+private:
+    const char *name;
+    int64_t value;
+    int64_t startNs;
+};
+
+void clearTrace() {
+/**
+ * Forgets every span recorded so far. Only call it while no other thread is recording.
+ */
+    lock_guard<mutex> lock(traceBuffersMutex);
+    for (auto &buffer : traceBuffers) {
+        buffer->recorded = 0;
+    }
+}
+
+bool writeChromeTrace(const string &path) {
+/**
+ * Writes the spans of every thread in the Chrome trace event format, as complete ("X") events with
+ * microsecond times. Only call it while no other thread is recording.
+
+ * @param path The JSON file to write.
+ * @return false if the file couldn't be written.
+ */
+    FILE *file = fopen(path.c_str(), "w");
+    if (!file) {
+        return false;
+    }
+    lock_guard<mutex> lock(traceBuffersMutex);
+    fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    bool first = true;
+    for (auto &buffer : traceBuffers) {
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}",
+                first ? "" : ",\n", buffer->threadId, buffer->threadId);
+        first = false;
+        uint64_t oldest = buffer->recorded > TRACE_BUFFER_EVENTS ? buffer->recorded - TRACE_BUFFER_EVENTS : 0;
+        for (uint64_t i = oldest; i < buffer->recorded; ++i) {
+            const TraceEvent &event = buffer->events[i % TRACE_BUFFER_EVENTS];
+            fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f",
+                    event.name, buffer->threadId, event.startNs / 1000.0, event.durationNs / 1000.0);
+            if (event.value != TRACE_NO_VALUE) {
+                fprintf(file, ",\"args\":{\"value\":%lld}", (long long)event.value);
+            }
+            fprintf(file, "}");
+        }
+    }
+    fprintf(file, "\n]}\n");
+    return fclose(file) == 0;
+}
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SPAN(name) TraceSpan TRACE_CONCAT(traceSpan, __LINE__)(name)
+#define TRACE_SPAN_VALUE(name, value) TraceSpan TRACE_CONCAT(traceSpan, __LINE__)(name, value)
+#define TRACE_SPAN_IF(condition, name, value) TraceSpan TRACE_CONCAT(traceSpan, __LINE__)(name, value, condition)
+
+#else
+
+#include <string>
+
+#define TRACE_SPAN(name)
+#define TRACE_SPAN_VALUE(name, value)
+#define TRACE_SPAN_IF(condition, name, value)
+
+void clearTrace() {}
+
+bool writeChromeTrace(const string &) {
+    return false;
+}
+
+#endif // ONITAMA_TRACE
+
+#endif // TRACE_H